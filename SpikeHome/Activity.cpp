@@ -20,6 +20,12 @@ Activity::Activity(device_t deviceNo)
     mActivityTimeInMilliseconds = 0;
     mLightSwichtdOnByCommand = false;
     NotifyTarget::setCheckMask(NotifyTarget::CHECKSTATE_NORMAL);
+    NotifyTarget::subscribe(MOVEMENT_NOTIFICATION);
+    NotifyTarget::subscribe(INIT_LIGHT_TIME_KEY);
+    NotifyTarget::subscribe(INC_LIGHT_TIME_KEY);
+    NotifyTarget::subscribe(MAX_LIGHT_TIME_KEY);
+    NotifyTarget::subscribe(FS20_COMMMAND);
+    NotifyTarget::subscribe(SET_LIGHT_TIME);
     initConfig();
 }
 
@@ -0,0 +1,196 @@
+/**
+ * ---------------------------------------------------------------------------------------------------
+ * This software is licensed under the GNU LESSER GENERAL PUBLIC LICENSE Version 3. It is furnished
+ * "as is", without any support, and with no warranty, express or implied, as to its usefulness for
+ * any purpose.
+ *
+ * File:      Aggregate.h
+ * Purpose:   Collects minimum, maximum, mean and amount of the samples of a sensor within a window.
+ *            At window end the statistics are frozen to a record and sent to the server instead of
+ *            every single change (see State::setAggregation). A record consists of an
+ *            AGGREGATE_ID_NOTIFICATION ('#') with the notify key of the sensor as value, followed by
+ *            four AGGREGATE_VALUE_NOTIFICATION ('$') messages: minimum, maximum, mean, samples.
+ *            A record not completely sent at the end of the next window is replaced.
+ *            The window length is stored in the configuration of the device. Its key is derived from
+ *            the notify key of the sensor ('a' .. 'z'): 1 + (notifyKey - 'a'). Example: the window of
+ *            the brightness sensor ('b') has the key 2, a window of 0 seconds disables the aggregation.
+ *            The mean is calculated from at most MAX_SAMPLES samples, one sample per checkState call.
+ *            The window is limited to the time these samples cover at the check rate of the sensor
+ *            (see getMaxWindow), about 87 minutes with CHECKSTATE_NORMAL. Minimum and maximum cover
+ *            the whole window, even if more samples arrive.
+ *
+ * Author:    Volker Böhm
+ * Copyright: Volker Böhm
+ * Version:   1.0
+ * ---------------------------------------------------------------------------------------------------
+ */
+
+#ifndef __AGGREGATE_H
+#define __AGGREGATE_H
+
+#include "StdInclude.h"
+
+class Aggregate {
+public:
+
+    /**
+     * Fields of a record
+     */
+    static const uint8_t MINIMUM    = 0;
+    static const uint8_t MAXIMUM    = 1;
+    static const uint8_t MEAN       = 2;
+    static const uint8_t SAMPLES    = 3;
+    static const uint8_t FIELDS     = 4;
+
+    static const key_t    NO_WINDOW_KEY = 0;
+    static const uint16_t MAX_SAMPLES   = 0xFFFF;
+
+    /**
+     * Constructs an aggregate, the first window starts at reboot
+     * @param windowInSeconds length of the window, 0 = no aggregation
+     */
+    Aggregate(value_t windowInSeconds) : mWindowInSeconds(windowInSeconds), mMessage(NO_RECORD)
+    {
+        reset(0);
+    }
+
+    /**
+     * Checks, if the aggregation is enabled
+     */
+    bool isActive() const { return mWindowInSeconds != 0; }
+
+    /**
+     * Sets the length of the window and starts a new window
+     * @param windowInSeconds length of the window, 0 = no aggregation
+     * @param scheduleLoops number of checkState loops since reboot
+     */
+    void setWindow(value_t windowInSeconds, time_t scheduleLoops)
+    {
+        mWindowInSeconds = windowInSeconds;
+        reset(scheduleLoops);
+    }
+
+    /**
+     * Gets the longest window covered by MAX_SAMPLES samples
+     * @param checkMask check mask of the sensor, one sample every checkMask + 1 loops
+     * @return maximal window length in seconds
+     */
+    static value_t getMaxWindow(uint8_t checkMask)
+    {
+        uint32_t maxWindow = uint32_t(MAX_SAMPLES) * (uint16_t(checkMask) + 1) / NotifyTarget::LOOPS_PER_SECOND;
+        return maxWindow > 0xFFFF ? 0xFFFF : value_t(maxWindow);
+    }
+
+    /**
+     * Adds a sample to the current window. Samples above MAX_SAMPLES only update minimum and maximum
+     * @param value sample value
+     */
+    void add(value_t value)
+    {
+        if (mSamples == 0 || value < mMinimum) {
+            mMinimum = value;
+        }
+        if (mSamples == 0 || value > mMaximum) {
+            mMaximum = value;
+        }
+        if (mSamples < MAX_SAMPLES) {
+            mSum += value;
+            mSamples++;
+        }
+    }
+
+    /**
+     * Checks, if the current window is elapsed
+     * @param scheduleLoops number of checkState loops since reboot
+     */
+    bool isWindowElapsed(time_t scheduleLoops) const
+    {
+        return scheduleLoops - mWindowStart >= time_t(mWindowInSeconds) * NotifyTarget::LOOPS_PER_SECOND;
+    }
+
+    /**
+     * Freezes the statistics of the current window to the record and starts a new window. A window
+     * without samples creates no record.
+     * @param scheduleLoops number of checkState loops since reboot
+     */
+    void closeWindow(time_t scheduleLoops)
+    {
+        if (mSamples != 0) {
+            mRecord[MINIMUM] = mMinimum;
+            mRecord[MAXIMUM] = mMaximum;
+            mRecord[MEAN] = (mSum + mSamples / 2) / mSamples;
+            mRecord[SAMPLES] = mSamples;
+            mMessage = 0;
+        }
+        reset(scheduleLoops);
+    }
+
+    /**
+     * Checks, if messages of the record are not yet sent
+     */
+    bool isRecordPending() const { return mMessage != NO_RECORD; }
+
+    /**
+     * Gets the index of the next message of the record to send
+     * @return 0 = record id, 1 .. FIELDS = field value
+     */
+    uint8_t getMessage() const { return mMessage; }
+
+    /**
+     * Marks the current message of the record as sent
+     */
+    void nextMessage()
+    {
+        mMessage++;
+        if (mMessage > FIELDS) {
+            mMessage = NO_RECORD;
+        }
+    }
+
+    /**
+     * Gets a field of the last record
+     * @param field MINIMUM .. SAMPLES
+     */
+    value_t getRecordValue(uint8_t field) const { return mRecord[field]; }
+
+    /**
+     * Derives the configuration key of the window length from the notify key of a sensor
+     * @param notifyKey notify key of the sensor ('a' .. 'z')
+     * @return configuration key, NO_WINDOW_KEY if the notify key is no lower case letter
+     */
+    static key_t getWindowKey(key_t notifyKey)
+    {
+        if (notifyKey < 'a' || notifyKey > 'z') {
+            return NO_WINDOW_KEY;
+        }
+        return 1 + (notifyKey - 'a');
+    }
+
+private:
+
+    static const uint8_t NO_RECORD = 0xFF;
+
+    /**
+     * Starts a new window
+     * @param scheduleLoops number of checkState loops since reboot
+     */
+    void reset(time_t scheduleLoops)
+    {
+        mWindowStart = scheduleLoops;
+        mMinimum = 0;
+        mMaximum = 0;
+        mSum = 0;
+        mSamples = 0;
+    }
+
+    value_t  mWindowInSeconds;
+    time_t   mWindowStart;
+    value_t  mMinimum;
+    value_t  mMaximum;
+    uint32_t mSum;
+    uint16_t mSamples;
+    value_t  mRecord[FIELDS];
+    uint8_t  mMessage;
+};
+
+#endif // __AGGREGATE_H
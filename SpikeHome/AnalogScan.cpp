@@ -0,0 +1,116 @@
+/**
+ * ---------------------------------------------------------------------------------------------------
+ * This software is licensed under the GNU LESSER GENERAL PUBLIC LICENSE Version 3. It is furnished
+ * "as is", without any support, and with no warranty, express or implied, as to its usefulness for
+ * any purpose.
+ *
+ * File:      AnalogScan.cpp
+ *
+ * Author:    Volker Böhm
+ * Copyright: Volker Böhm
+ * Version:   1.0
+ * ---------------------------------------------------------------------------------------------------
+ */
+
+#include "AnalogScan.h"
+
+uint8_t             AnalogScan::mChannel[MAX_CHANNELS];
+volatile value_t    AnalogScan::mValue[MAX_CHANNELS];
+uint8_t             AnalogScan::mChannels;
+uint8_t             AnalogScan::mOversamplingShift = DEFAULT_OVERSAMPLING_SHIFT;
+volatile uint8_t    AnalogScan::mCurrent;
+volatile uint8_t    AnalogScan::mSamples;
+volatile uint16_t   AnalogScan::mSum;
+volatile uint16_t   AnalogScan::mScans;
+
+ISR(ADC_vect)
+{
+    AnalogScan::onConversion();
+}
+
+void AnalogScan::onConversion()
+{
+    value_t sample = ADC;
+    // The first conversion after switching the channel is discarded
+    if (mSamples > 0) {
+        mSum += sample;
+    }
+    mSamples++;
+    if (mSamples > (1 << mOversamplingShift)) {
+        mValue[mCurrent] = mSum >> mOversamplingShift;
+        mSum = 0;
+        mSamples = 0;
+        mCurrent++;
+        if (mCurrent >= mChannels) {
+            mCurrent = 0;
+            mScans++;
+        }
+        select(mCurrent);
+    }
+    ADCSRA |= _BV(ADSC);
+}
+
+value_t AnalogScan::read(pin_t pin)
+{
+    value_t value;
+    uint8_t index = find(toChannel(pin));
+    if (index != NOT_FOUND) {
+        uint8_t oldSREG = SREG;
+        cli();
+        value = mValue[index];
+        SREG = oldSREG;
+    } else {
+        // New or unscannable channel: the ADC is needed for analogRead
+        stop();
+        value = analogRead(pin);
+        attach(toChannel(pin), value);
+        start();
+    }
+    return value;
+}
+
+uint8_t AnalogScan::find(uint8_t channel)
+{
+    for (uint8_t index = 0; index < mChannels; index++) {
+        if (mChannel[index] == channel) {
+            return index;
+        }
+    }
+    return NOT_FOUND;
+}
+
+void AnalogScan::attach(uint8_t channel, value_t value)
+{
+    if (channel >= MAX_CHANNELS || mChannels >= MAX_CHANNELS) {
+        return;
+    }
+    mValue[mChannels] = value;
+    mChannel[mChannels] = channel;
+    mChannels++;
+}
+
+void AnalogScan::setOversampling(uint8_t shift)
+{
+    stop();
+    mOversamplingShift = min(shift, MAX_OVERSAMPLING_SHIFT);
+    start();
+}
+
+void AnalogScan::stop()
+{
+    ADCSRA &= ~_BV(ADIE);
+    while ((ADCSRA & _BV(ADSC)) != 0) {}
+    // Clears a pending interrupt flag by writing a one
+    ADCSRA |= _BV(ADIF);
+}
+
+void AnalogScan::start()
+{
+    if (mChannels > 0) {
+        // The samples of the stopped conversion are discarded, the channel is sampled again
+        mSamples = 0;
+        mSum = 0;
+        select(mCurrent);
+        ADCSRA |= _BV(ADIE) | _BV(ADSC);
+    }
+}
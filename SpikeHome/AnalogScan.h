@@ -0,0 +1,133 @@
+/**
+ * ---------------------------------------------------------------------------------------------------
+ * This software is licensed under the GNU LESSER GENERAL PUBLIC LICENSE Version 3. It is furnished
+ * "as is", without any support, and with no warranty, express or implied, as to its usefulness for
+ * any purpose.
+ *
+ * File:      AnalogScan.h
+ * Purpose:   Interrupt driven scan of the analog inputs. The conversion complete interrupt stores the
+ *            result and starts the next conversion, thus the ADC runs continuously over all registered
+ *            channels without blocking the schedule. Every channel is sampled 2^shift times (oversampling)
+ *            and the average is stored in a table (decimation). The first conversion after switching the
+ *            channel is discarded to let the sample and hold capacitor settle.
+ *            A pin is registered by its first read (see read). The first read is blocking (analogRead),
+ *            every further read returns the latest average in constant time, the value of the first read
+ *            until the scan reaches the new channel. Registering a channel continues the scan with the
+ *            channel converted before.
+ *            With three channels and 4 samples a channel is updated every 1.6 ms.
+ *            The ADC is owned by the scan once a channel is registered, do not call analogRead directly.
+ *
+ * Author:    Volker Böhm
+ * Copyright: Volker Böhm
+ * Version:   1.0
+ * ---------------------------------------------------------------------------------------------------
+ */
+
+#ifndef __ANALOGSCAN_H
+#define __ANALOGSCAN_H
+
+#include "StdInclude.h"
+
+class AnalogScan {
+public:
+
+    /**
+     * Maximal amount of channels scanned (ADC0 .. ADC7)
+     */
+    static const uint8_t MAX_CHANNELS = 8;
+
+    static const uint8_t DEFAULT_OVERSAMPLING_SHIFT = 2;
+    static const uint8_t MAX_OVERSAMPLING_SHIFT = 4;
+
+    /**
+     * Reads the latest average of an analog pin. Registers the pin for scanning on the first read,
+     * the first read is blocking. Pins that cannot be scanned (channels above ADC7, for example A8 .. A15
+     * of the Mega) are read blocking on every call: the scan is stopped for the conversion of analogRead
+     * and continues with the interrupted channel afterwards.
+     * @param pin analog pin (A0 .. A7)
+     * @return analog value 0 .. 1023
+     */
+    static value_t read(pin_t pin);
+
+    /**
+     * Sets the amount of samples averaged per channel
+     * @param shift 2^shift samples are averaged, 0 .. MAX_OVERSAMPLING_SHIFT
+     */
+    static void setOversampling(uint8_t shift);
+
+    /**
+     * Gets the amount of complete scans of all channels
+     * @return amount of scans (wraps at 65535)
+     */
+    static uint16_t getScans() { return mScans; }
+
+    /**
+     * Gets the amount of scanned channels
+     */
+    static uint8_t getChannels() { return mChannels; }
+
+    /**
+     * Interrupt handler of the conversion complete interrupt
+     */
+    static void onConversion();
+
+private:
+    AnalogScan() {}
+
+    static const uint8_t NOT_FOUND = 0xFF;
+
+    /**
+     * Gets the index of a channel in the channel table
+     * @param channel ADC channel
+     * @return index of the channel, NOT_FOUND if the channel is not scanned
+     */
+    static uint8_t find(uint8_t channel);
+
+    /**
+     * Registers a channel for scanning, the scan must be stopped
+     * @param channel ADC channel
+     * @param value value of the channel until its first average is stored
+     */
+    static void attach(uint8_t channel, value_t value);
+
+    /**
+     * Stops the scan after the running conversion
+     */
+    static void stop();
+
+    /**
+     * Starts the scan, if channels are registered. The scan continues with the current channel
+     */
+    static void start();
+
+    /**
+     * Selects the channel of the next conversion
+     * @param index index of the channel in the channel table
+     */
+    static void select(uint8_t index)
+    {
+        ADMUX = _BV(REFS0) | mChannel[index];
+    }
+
+    /**
+     * Gets the ADC channel of a pin
+     * @param pin analog pin
+     * @return ADC channel
+     */
+    static uint8_t toChannel(pin_t pin)
+    {
+        return pin >= A0 ? pin - A0 : pin;
+    }
+
+    static uint8_t              mChannel[MAX_CHANNELS];
+    static volatile value_t     mValue[MAX_CHANNELS];
+    static uint8_t              mChannels;
+    static uint8_t              mOversamplingShift;
+
+    static volatile uint8_t     mCurrent;
+    static volatile uint8_t     mSamples;
+    static volatile uint16_t    mSum;
+    static volatile uint16_t    mScans;
+};
+
+#endif // __ANALOGSCAN_H
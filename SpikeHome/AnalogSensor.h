@@ -17,9 +17,13 @@
 #define __ANALOGSENSOR_H
 
 #include "StdInclude.h"
-#include "State.h"
+#include "SensorT.h"
 
-class AnalogSensor : public State {
+/**
+ * Average of 6 reads, changes are notified if they are larger than 10 and at least 20% of the value
+ * (defaults of the report policy). The samples may be aggregated, disabled by default.
+ */
+class AnalogSensor : public SensorT<AnalogPinReader, AverageFilter<6>, AnyChange> {
 public:
 
     /**
@@ -29,56 +33,12 @@ public:
      * @param notifyKey key to notify for changed values
      */
     AnalogSensor(device_t deviceNo, pin_t pin, bool inverted, key_t notifyKey)
-    : State(deviceNo, notifyKey), mPin(pin), mInverted(inverted) { }
-
-protected:
-
-    /**
-     * Reads an analog value from an analog input pin
-     * @return analog value of mPin, invertet if mInvert = true
-     */
-    value_t analogReadState()
-    {
-        value_t state = analogRead(mPin);
-        if (mInverted) {
-            state = MAX_ANALOG_READ_VALUE - state;
-        }
-        return state;
-    }
-
-    /*
-     * Reads/Gets the current status value
-     * @return average value of last reads
-     */
-    virtual StateValue getValue()
+    : SensorT(deviceNo, notifyKey, AnalogPinReader(pin, inverted))
     {
-        value_t state = analogReadState();
-        return value_t((mLastValue.toInt() * 5 + state) / 6);
+        setReportPolicy(10, 20, 5, 0);
+        setAggregation(0);
     }
 
-    /**
-     * Checks if the state has changed.
-     * @param curValue current state value
-     * @param lastValue last state value
-     * @return true, if state has changed enough (see constants)
-     */
-    virtual bool hasChanged(StateValue curValue, StateValue lastValue)
-    {
-
-        bool enoughAbsoluteChange = abs(curValue.toInt() - lastValue.toInt()) > ABSOLUTE_CHANGE_TO_SEND;
-        float relChangeToSend = REL_CHANGE_TO_SEND * curValue.toInt();
-
-        bool enoughRelativeChange = abs(lastValue.toInt() - curValue.toInt()) >= relChangeToSend;
-
-        return enoughAbsoluteChange && enoughRelativeChange;
-    }
-
-    pin_t mPin;
-    bool mInverted;
-
-    static const value_t ABSOLUTE_CHANGE_TO_SEND = 10;
-    static constexpr float REL_CHANGE_TO_SEND = 0.2;
-
 };
 
 #endif // __ANALOGSENSOR_H
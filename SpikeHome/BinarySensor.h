@@ -6,7 +6,8 @@
  *
  * File:      BinarySensor.h
  * Purpouse:  Controls a generic sensor with a binary status, either by reading an analog or a digital
- *            pin
+ *            pin. Digital pins are debounced (see DigitalInputs), thus contact bounces of reed switches
+ *            do not send changes.
  * Author:    Volker Böhm
  * Copyright: Volker Böhm
  * Version:   1.0
@@ -17,9 +18,9 @@
 #define __BINARYSENSOR_H
 
 #include "StdInclude.h"
-#include "State.h"
+#include "SensorT.h"
 
-class BinarySensor : public State {
+class BinarySensor : public SensorT<DigitalPinReader, NoFilter, AnyChange> {
 public:
 
     /**
@@ -30,10 +31,10 @@ public:
      * @param notifyKey identifier to send notifications
      */
     BinarySensor(device_t deviceNo, pin_t pin, bool invert, key_t notifyKey)
-    : State(deviceNo, notifyKey), mPin(pin), mInvert(invert)
+    : SensorT(deviceNo, notifyKey, DigitalPinReader(pin, invert))
     {
-        pinMode(mPin, INPUT);
-        mLastValue = mInvert ? HIGH : LOW;
+        pinMode(pin, INPUT);
+        mLastValue = invert ? HIGH : LOW;
     }
 
     /**
@@ -41,24 +42,9 @@ public:
      */
     void setPullup()
     {
-        State::setPullup(mPin);
+        State::setPullup(mReader.mPin);
     }
 
-
-protected:
-
-    /**
-     * Reads the status of the input (either analog or digital)
-     * @returns the status value either "LOW" or "HIGH"
-     */
-    virtual StateValue getValue()
-    {
-        return digitalReadState(mPin, mInvert);
-    }
-
-    pin_t mPin;
-    bool mInvert;
-
 };
 
 #endif // __BINARYSENSOR_H
@@ -0,0 +1,104 @@
+/**
+ * ---------------------------------------------------------------------------------------------------
+ * This software is licensed under the GNU LESSER GENERAL PUBLIC LICENSE Version 3. It is furnished
+ * "as is", without any support, and with no warranty, express or implied, as to its usefulness for
+ * any purpose.
+ *
+ * File:      BrightnessControl.h
+ * Purpose:   Integer PI controller keeping the brightness of a room constant by the light level.
+ *            Called once per control period with the target and the measured brightness in percent of
+ *            the full on brightness, it returns the next light level within a range (the calibrated
+ *            start and full on voltage of the light).
+ *            Gains are fixed point values in 1/256 level per percent (GAIN_ONE = 1 level per percent),
+ *            the integral gain is applied once per control period.
+ *            Anti-windup: the integral is not advanced while the output is saturated in the direction of
+ *            the error and it is always kept within the output range.
+ *            The class uses plain integer types only, it is compiled by the host simulation in
+ *            extras/LightControlSim as well.
+ *
+ * Author:    Volker Böhm
+ * Copyright: Volker Böhm
+ * Version:   1.0
+ * ---------------------------------------------------------------------------------------------------
+ */
+
+#ifndef __BRIGHTNESSCONTROL_H
+#define __BRIGHTNESSCONTROL_H
+
+#include <stdint.h>
+
+class BrightnessControl {
+public:
+
+    /**
+     * Gain of 1 level per percent
+     */
+    static const uint16_t GAIN_ONE = 256;
+
+    static const uint16_t DEFAULT_PROPORTIONAL_GAIN = 128;
+    static const uint16_t DEFAULT_INTEGRAL_GAIN = 96;
+
+    BrightnessControl() : mProportionalGain(DEFAULT_PROPORTIONAL_GAIN), mIntegralGain(DEFAULT_INTEGRAL_GAIN), mIntegral(0) {}
+
+    /**
+     * Sets the gains
+     * @param proportionalGain level change per percent error in 1/256
+     * @param integralGain level change per percent error and control period in 1/256
+     */
+    void setGains(uint16_t proportionalGain, uint16_t integralGain)
+    {
+        mProportionalGain = proportionalGain;
+        mIntegralGain = integralGain;
+    }
+
+    /**
+     * Sets the integral to a level, the next output continues from this level without a jump
+     * @param level current light level
+     */
+    void reset(int16_t level)
+    {
+        mIntegral = int32_t(level) << FRACTION_BITS;
+    }
+
+    /**
+     * Calculates the light level of the next control period
+     * @param targetInPercent target brightness in percent of the full on brightness
+     * @param measuredInPercent measured brightness in percent of the full on brightness
+     * @param minLevel lowest light level
+     * @param maxLevel highest light level
+     * @return light level minLevel .. maxLevel
+     */
+    int16_t step(int16_t targetInPercent, int16_t measuredInPercent, int16_t minLevel, int16_t maxLevel)
+    {
+        int32_t error = int32_t(targetInPercent) - measuredInPercent;
+        int32_t low = int32_t(minLevel) << FRACTION_BITS;
+        int32_t high = int32_t(maxLevel) << FRACTION_BITS;
+        int32_t integral = mIntegral + error * mIntegralGain;
+        int32_t output = error * mProportionalGain + integral;
+
+        if (output > high) {
+            output = high;
+            if (error < 0) {
+                mIntegral = integral;
+            }
+        } else if (output < low) {
+            output = low;
+            if (error > 0) {
+                mIntegral = integral;
+            }
+        } else {
+            mIntegral = integral;
+        }
+        mIntegral = mIntegral > high ? high : (mIntegral < low ? low : mIntegral);
+        return int16_t((output + (1 << (FRACTION_BITS - 1))) >> FRACTION_BITS);
+    }
+
+private:
+    static const uint8_t FRACTION_BITS = 8;
+
+    uint16_t mProportionalGain;
+    uint16_t mIntegralGain;
+    int32_t  mIntegral;
+};
+
+#endif // __BRIGHTNESSCONTROL_H
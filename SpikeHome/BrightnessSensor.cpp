@@ -21,11 +21,9 @@ BrightnessSensor::BrightnessSensor(device_t deviceNo, pin_t analogPin)
 {
     State::setPullup(analogPin);
     mFullOnBrightness = addConfigValue(FULL_ON_VALUE_KEY, MAX_ANALOG_READ_VALUE / 2);
-}
-
-bool BrightnessSensor::hasChanged(StateValue curValue, StateValue lastValue)
-{
-    return abs((int16_t) curValue.toInt() - (int16_t) lastValue.toInt()) > 5;
+    NotifyTarget::subscribe(FULL_ON_VALUE_KEY);
+    setReportPolicy(5, 0, 5, 0);
+    setAggregation(0);
 }
 
 value_t BrightnessSensor::getAbsoluteValue()
@@ -57,6 +55,8 @@ void BrightnessSensor::handleChange(address_t senderAddress, key_t key, StateVal
             setConfigValue(FULL_ON_VALUE_KEY, value);
             mFullOnBrightness = value;
         }
+    } else {
+        State::handleChange(senderAddress, key, data);
     }
 };
 
@@ -40,14 +40,6 @@ public:
 
 protected:
 
-    /**
-     * Checks if the state has changed enhough to notify the server.
-     * @param curValue current state value
-     * @param lastValue last state value
-     * @return true, if state has changed
-     */
-    virtual bool hasChanged(StateValue curValue, StateValue lastValue);
-
     /**
      * Gets the brightness of light. Return a reverse value, because light sensor is plugged
      * between ground and input. More light leads to lower values.
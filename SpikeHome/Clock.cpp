@@ -19,6 +19,8 @@
 Clock::Clock(device_t deviceNo) : NotifyTarget(deviceNo), loops(0), initialized(false)
 {
     NotifyTarget::setCheckMask(NotifyTarget::CHECKSTATE_ALLWAYS);
+    NotifyTarget::unsubscribeAll();
+    NotifyTarget::subscribe(CLOCK_KEY);
 }
 
 
@@ -24,7 +24,11 @@ class Config : public NotifyTarget {
 public:
 
 
-    Config() : mEEPROM(100) {}
+    Config() : mEEPROM(100)
+    {
+        NotifyTarget::setPriority(NotifyTarget::PRIORITY_BACKGROUND);
+        NotifyTarget::unsubscribeAll();
+    }
 
     /**
      * Gets a value identified by id
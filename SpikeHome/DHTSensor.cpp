@@ -12,126 +12,184 @@
 
 #include "DHTSensor.h"
 
-#ifdef __DEBUG
-#define IF_DEBUG(x) x
-char buf[1024];
-int bufIndex;
-#else
-#define IF_DEBUG(x)
-#endif
+DHTSensor* volatile DHTSensor::mpTransferring = 0;
 
 DHTSensor::DHTSensor(device_t deviceNo, pin_t pin)
     :NotifyTarget(deviceNo), mPin(pin)
 {
+    mReadOK = true;
     mLastReadOK = true;
+    mHumidity = NO_SAMPLE;
+    mTemperature = NO_SAMPLE;
+    mSampleTime = 0;
+    mSampleIntervalInSeconds = addConfigValue(SAMPLE_INTERVAL_KEY, DEFAULT_SAMPLE_INTERVAL_IN_SECONDS);
+    mEdges = 0;
+    mpInput = portInputRegister(digitalPinToPort(pin));
+    mBitMask = digitalPinToBitMask(pin);
+    mInterruptNo = NOT_AN_INTERRUPT;
+#ifdef digitalPinToInterrupt
+    mInterruptNo = digitalPinToInterrupt(pin);
+#endif
+    NotifyTarget::setCheckMask(NotifyTarget::CHECKSTATE_SELDOM);
+    NotifyTarget::setPriority(NotifyTarget::PRIORITY_BACKGROUND);
+    NotifyTarget::unsubscribeAll();
+    NotifyTarget::subscribe(SAMPLE_INTERVAL_KEY);
 }
 
-bool DHTSensor::getValue(float& humidity, float& temperature)
+void DHTSensor::checkState(time_t scheduleLoops)
 {
-    uint8_t readBuffer[5];
-    humidity = NAN;
-    temperature = NAN;
-    bool result = false;
-
-    if (readData(readBuffer)) {
-
-        humidity = word(readBuffer[0], readBuffer[1]) * 0.1;
-        temperature = word(readBuffer[2] & 0x7F, readBuffer[3]) * 0.1;
+    runMeasurement();
+}
 
-        if (readBuffer[2] & 0x80)
-        {
-            temperature = -temperature;
+void DHTSensor::handleChange(address_t senderAddress, key_t key, StateValue data)
+{
+    if (key == SAMPLE_INTERVAL_KEY) {
+        value_t value = data.toInt();
+        if (value >= MIN_SAMPLE_INTERVAL_IN_SECONDS) {
+            setConfigValue(SAMPLE_INTERVAL_KEY, value);
+            mSampleIntervalInSeconds = value;
         }
+    }
+}
 
-        if (readBuffer[4] == uint8_t(readBuffer[0] + readBuffer[1] + readBuffer[2] + readBuffer[3]))
-        {
-            result = true;
+bool DHTSensor::runMeasurement()
+{
+    TASK_BEGIN(mTask);
+    while (true) {
+        // The sensor needs some time after power on and between two reads
+        TASK_WAIT_MS(mTask, time_t(mSampleIntervalInSeconds) * 1000 - WAIT_FOR_POWER_IN_MILLISECONDS);
+        pinMode(mPin, OUTPUT);
+        digitalWrite(mPin, HIGH);
+        TASK_WAIT_MS(mTask, WAIT_FOR_POWER_IN_MILLISECONDS);
+
+        digitalWrite(mPin, LOW);
+        TASK_WAIT_MS(mTask, WAIT_FOR_WAKEUP_IN_MILLISECONDS);
+
+        // Only one sensor may use the interrupt handler at a time
+        TASK_WAIT_UNTIL(mTask, mInterruptNo == NOT_AN_INTERRUPT || mpTransferring == 0);
+        startTransfer();
+        if (mInterruptNo == NOT_AN_INTERRUPT) {
+            pollTransfer();
+        } else {
+            TASK_WAIT_MS(mTask, WAIT_FOR_TRANSFER_IN_MILLISECONDS);
+        }
+        endTransfer();
+
+        mLastReadOK = mReadOK;
+        mReadOK = getValueFromSensor(mHumidity, mTemperature);
+        if (mReadOK) {
+            mSampleTime = millis();
+            notify(HUMIDITY_NOTIFICATION, mHumidity);
+            notify(TEMPERATURE_NOTIFICATION, mTemperature);
         }
     }
-    return result;
+    TASK_END(mTask);
 }
 
-void DHTSensor::requestData()
+bool DHTSensor::getValue(int16_t& humidity, int16_t& temperature)
 {
-    pinMode(mPin, OUTPUT);
-    digitalWrite(mPin, HIGH);
-    delay(20);
-
-    digitalWrite(mPin, LOW);
-    delay(WAIT_FOR_WAKEUP_IN_MILLISECONDS);
+    humidity = mHumidity;
+    temperature = mTemperature;
+    return isSampleUsable();
+}
 
-    digitalWrite(mPin, HIGH);
-    delayMicroseconds(WAIT_FOR_INPUT_IN_MICROSECONDS);
-    pinMode(mPin, INPUT);
+bool DHTSensor::isSampleUsable()
+{
+    return mHumidity != NO_SAMPLE && getSampleAgeInSeconds() <= time_t(mSampleIntervalInSeconds) * MAX_SAMPLE_AGE_INTERVALS;
 }
 
-int16_t DHTSensor::waitForSignal(int16_t signal, int16_t loops)
+bool DHTSensor::getValueFromSensor(int16_t& humidity, int16_t& temperature)
 {
-    int16_t index;
+    bool result = mEdges >= TRANSFER_EDGES &&
+        mBits[4] == uint8_t(mBits[0] + mBits[1] + mBits[2] + mBits[3]);
+
+    // A failed read keeps the last sample
+    if (result) {
 
-    for (index = 0; index < loops; index++) {
-        uint8_t pinValue = digitalRead(mPin);
-        IF_DEBUG(if (bufIndex < 1023) { buf[bufIndex] = pinValue == HIGH ? '1' : '.'; bufIndex++; })
-        if (pinValue == signal) {
-            break;
+        // The sensor sends tenths
+        humidity = word(mBits[0], mBits[1]) * 10;
+        temperature = word(mBits[2] & 0x7F, mBits[3]) * 10;
+
+        if (mBits[2] & 0x80)
+        {
+            temperature = -temperature;
         }
-        delayMicroseconds(9);
     }
-    return index == loops ? -1 : index;
+    return result;
 }
 
-bool DHTSensor::readData(uint8_t readBuffer[5])
+void DHTSensor::startTransfer()
 {
-
-    // INIT BUFFERVAR TO RECEIVE DATA
-    bool timeout = false;
-    int16_t loopCount;
-
-
     for (uint8_t i = 0; i < 5; i++) {
-        readBuffer[i] = 0;
+        mBits[i] = 0;
     }
+    mEdges = 0;
+    mRiseTime = micros();
+    if (mInterruptNo != NOT_AN_INTERRUPT) {
+        // Attached before releasing the line, the first edges follow within 40 microseconds
+        mpTransferring = this;
+        attachInterrupt(mInterruptNo, onEdge, CHANGE);
+    }
+    digitalWrite(mPin, HIGH);
+    delayMicroseconds(WAIT_FOR_INPUT_IN_MICROSECONDS);
+    pinMode(mPin, INPUT);
+}
 
-    requestData();
-    IF_DEBUG(bufIndex = 0;)
-    
-    // Turn off interrupts temporarily due to time critical section.
-    cli();
-
-    delayMicroseconds(10);
-    timeout |= waitForSignal(HIGH, WAIT_FOR_ACKNOWLEDGE_LOOPS) == -1;
-    timeout |= waitForSignal(LOW, WAIT_FOR_ACKNOWLEDGE_LOOPS) == -1;
-
-    for (uint8_t i = 0; (i < 40) && !timeout; i++)
-    {
-        timeout |= waitForSignal(HIGH, WAIT_FOR_DATA_LOOPS) == -1;
-        loopCount = waitForSignal(LOW, WAIT_FOR_DATA_LOOPS);
-        timeout |= loopCount == -1;
-
-        readBuffer[i / 8] <<= 1;
-        readBuffer[i / 8] |= loopCount > 3 ? 1 : 0;
+void DHTSensor::pollTransfer()
+{
+    uint16_t startTime = micros();
+    uint8_t level = HIGH;
+    while (mEdges < TRANSFER_EDGES && uint16_t(micros() - startTime) < TRANSFER_TIMEOUT_IN_MICROSECONDS) {
+        uint8_t curLevel = readLevel();
+        if (curLevel != level) {
+            level = curLevel;
+            handleEdge(level, micros());
+        }
     }
+}
 
+void DHTSensor::endTransfer()
+{
+    if (mInterruptNo != NOT_AN_INTERRUPT) {
+        detachInterrupt(mInterruptNo);
+        mpTransferring = 0;
+    }
     pinMode(mPin, OUTPUT);
     digitalWrite(mPin, HIGH);
+}
 
-    sei();
-
-    IF_DEBUG(buf[bufIndex] = 0; Serial.println(buf);)
+void DHTSensor::onEdge()
+{
+    DHTSensor* pSensor = mpTransferring;
+    if (pSensor != 0) {
+        pSensor->handleEdge(pSensor->readLevel(), micros());
+    }
+}
 
-    return !timeout;
+void DHTSensor::handleEdge(uint8_t level, uint16_t timeInMicroseconds)
+{
+    if (level == HIGH) {
+        mRiseTime = timeInMicroseconds;
+    } else if (mEdges < TRANSFER_EDGES) {
+        if (mEdges >= FIRST_BIT_EDGE) {
+            uint8_t byteIndex = (mEdges - FIRST_BIT_EDGE) / 8;
+            bool isOne = uint16_t(timeInMicroseconds - mRiseTime) >= ONE_BIT_MIN_IN_MICROSECONDS;
+            mBits[byteIndex] = (mBits[byteIndex] << 1) | (isOne ? 1 : 0);
+        }
+        mEdges++;
+    }
 }
 
-float DHTSensor::getHumidity() {
-    float humidity;
-    float temperature;
+int16_t DHTSensor::getHumidity() {
+    int16_t humidity;
+    int16_t temperature;
     getValue(humidity, temperature);
     return humidity;
  }
 
- float DHTSensor::getTemperature() {
-    float humidity;
-    float temperature;
+ int16_t DHTSensor::getTemperature() {
+    int16_t humidity;
+    int16_t temperature;
     getValue(humidity, temperature);
     return temperature;
  }
@@ -141,25 +199,23 @@ float DHTSensor::getHumidity() {
  */
 bool DHTSensor::notifyServer(uint16_t loopCount)
 {
-    float humidity;
-    float temperature;
-    bool readOK = getValue(humidity, temperature);
+    if (mHumidity == NO_SAMPLE && mReadOK) {
+        // Nothing measured yet
+        return true;
+    }
 
-    if (!readOK || !mLastReadOK) {
-        sendToServer(READ_ERROR_NOTIFICATION, readOK ? uint16_t(0) : uint16_t(1));
+    if (!mReadOK || !mLastReadOK) {
+        sendToServer(READ_ERROR_NOTIFICATION, mReadOK ? uint16_t(0) : uint16_t(1));
     }
 
-    if (readOK) {
+    if (isSampleUsable()) {
         if (loopCount == 0) {
-            sendToServer(HUMIDITY_NOTIFICATION, humidity);
+            sendToServer(HUMIDITY_NOTIFICATION, mHumidity);
         }
-        notify(HUMIDITY_NOTIFICATION, humidity);
         if (loopCount == 1) {
-            sendToServer(TEMPERATURE_NOTIFICATION, temperature);
+            sendToServer(TEMPERATURE_NOTIFICATION, mTemperature);
         }
-        notify(TEMPERATURE_NOTIFICATION, temperature);
     }
 
-    mLastReadOK = readOK;
     return loopCount >= 1;
 };
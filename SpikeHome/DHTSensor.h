@@ -6,6 +6,13 @@
  *
  * File:        DHTSensor.h
  * Purpose:     Controls a dht sensor and provides humidity and temperature
+ *              The transfer runs with interrupts enabled, bits are decoded from the width of the high
+ *              pulses measured between edges. On pins with an external interrupt (INTx) the edges are
+ *              timestamped by the interrupt and the transfer runs in the background between two ticks.
+ *              Other pins are polled for the 5 ms of the transfer, interrupts (serial bus) still work.
+ *              One sample feeds the notifications, the server reports and the getters. The sensor is
+ *              read every SAMPLE_INTERVAL_KEY seconds (at least 2 s, the limit of the DHT22), a sample
+ *              older than MAX_SAMPLE_AGE_INTERVALS intervals is not used any more.
  *
  * Author:      Volker Böhm
  * Copyright:   Volker Böhm
@@ -17,6 +24,7 @@
 #define __DHTSENSOR_H
 
 #include <StdInclude.h>
+#include "Task.h"
 
 class DHTSensor : public NotifyTarget {
 public:
@@ -30,46 +38,132 @@ public:
     DHTSensor(device_t deviceNo, pin_t pin);
 
     /**
-     * Measures humidity and retuns the value
-     * @return humidity
+     * Value of humidity and temperature before the first valid sample
      */
-    float getHumidity();
+    static const int16_t NO_SAMPLE = -32768;
 
     /**
-     * Meastures temperature and returns the value
-     * @return measured temperature
+     * Gets the humidity of the last measurement
+     * @return humidity in 1/100 percent
      */
-    float getTemperature();
+    int16_t getHumidity();
 
     /**
-     * Reads data from a DHT22 sensor
-     * @param humidity output: humidity read
-     * @param temperature output: temperature read
-     * @return true, if all ok, else false
+     * Gets the temperature of the last measurement
+     * @return measured temperature in 1/100 degree celsius
      */
-    bool getValue(float& humidity, float& temperature);
+    int16_t getTemperature();
+
+    /**
+     * Gets the values of the last measurement. The sensor is read every SAMPLE_INTERVAL_KEY seconds
+     * @param humidity output: humidity read in 1/100 percent
+     * @param temperature output: temperature read in 1/100 degree celsius
+     * @return true, if the last read was ok and the sample is not too old, else false
+     */
+    bool getValue(int16_t& humidity, int16_t& temperature);
+
+    /**
+     * Checks, if the last transfer completed with a valid sample
+     * @return true, if humidity and temperature are from a complete sample
+     */
+    bool isSampleComplete() { return mReadOK && mHumidity != NO_SAMPLE; }
+
+    /**
+     * Gets the time since the last valid sample
+     * @return age in seconds
+     */
+    time_t getSampleAgeInSeconds() { return (millis() - mSampleTime) / 1000; }
+
+    /**
+     * Runs the measurement task
+     * @param scheduleLoops number of checkState loops since reboot
+     */
+    virtual void checkState(time_t scheduleLoops);
+
+    /**
+     * Handles a change of the sample interval
+     * @param key key/identifier of the change
+     * @param data new value
+     */
+    virtual void handleChange(address_t senderAddress, key_t key, StateValue data);
 
 private:
 
     typedef int8_t dht_t;
+    static const value_t DEFAULT_SAMPLE_INTERVAL_IN_SECONDS = 10;
+    static const value_t MIN_SAMPLE_INTERVAL_IN_SECONDS = 2;
+    static const uint8_t MAX_SAMPLE_AGE_INTERVALS = 3;
+    static const time_t WAIT_FOR_POWER_IN_MILLISECONDS = 20;
     static const time_t WAIT_FOR_WAKEUP_IN_MILLISECONDS = 2;
     static const time_t WAIT_FOR_INPUT_IN_MICROSECONDS = 30;
-    static const time_t WAIT_FOR_ACKNOWLEDGE_LOOPS = 20;
-    static const time_t WAIT_FOR_DATA_LOOPS = 9;
+    static const time_t WAIT_FOR_TRANSFER_IN_MILLISECONDS = 10;
+    static const uint16_t TRANSFER_TIMEOUT_IN_MICROSECONDS = 6000;
+
+    /**
+     * A high pulse longer than this is a 1 bit (0: 26-28 us, 1: 70 us)
+     */
+    static const uint16_t ONE_BIT_MIN_IN_MICROSECONDS = 48;
 
     /**
-     * Requests data from sensor
+     * Falling edges of a transfer: start of the acknowledge, start of the first bit and the end of
+     * every of the 40 bits
      */
-    void requestData();
+    static const uint8_t FIRST_BIT_EDGE = 2;
+    static const uint8_t TRANSFER_EDGES = FIRST_BIT_EDGE + 40;
 
     /**
-     * Reads data from sensor into a read buffer
-     * @param readBuffer buffer to read data to
-     * @return true, if data read successfully, else false
+     * Measures humidity and temperature every sample interval and notifies the device
+     * @return true, while running (always)
      */
-    bool readData(uint8_t readBuffer[5]);
-    int _readSensor(uint8_t bits[5]);
+    bool runMeasurement();
 
+    /**
+     * Starts a transfer: releases the data line, the sensor answers with the data bits.
+     * The data line must have been pulled low for WAIT_FOR_WAKEUP_IN_MILLISECONDS before
+     */
+    void startTransfer();
+
+    /**
+     * Polls the data line until the transfer is complete, used for pins without external interrupt
+     */
+    void pollTransfer();
+
+    /**
+     * Checks, if the last sample is valid and not too old
+     * @return true, if the sample may be used
+     */
+    bool isSampleUsable();
+
+    /**
+     * Ends a transfer and drives the data line high
+     */
+    void endTransfer();
+
+    /**
+     * Decodes the data of the last transfer. The outputs are not changed, if the transfer failed
+     * @param humidity output: humidity read in 1/100 percent
+     * @param temperature output: temperature read in 1/100 degree celsius
+     * @return true, if all bits are received and the checksum is ok, else false
+     */
+    bool getValueFromSensor(int16_t& humidity, int16_t& temperature);
+
+    /**
+     * Handles an edge of the data line. A falling edge ends a high pulse, its width gives the bit
+     * @param level level after the edge
+     * @param timeInMicroseconds time of the edge (lower 16 bits)
+     */
+    void handleEdge(uint8_t level, uint16_t timeInMicroseconds);
+
+    /**
+     * Reads the data line
+     * @return HIGH or LOW
+     */
+    uint8_t readLevel() { return (*mpInput & mBitMask) != 0 ? HIGH : LOW; }
+
+    /**
+     * Interrupt handler of the data line of the sensor transferring
+     */
+    static void onEdge();
 
     /**
      * remembers the class to send notifications to the server. This function will be called
@@ -79,18 +173,22 @@ private:
      */
     virtual bool notifyServer(uint16_t loopCount);
 
-    /**
-     * Waits for a pin to have a dedicated signal
-     * @param signal signal to wait for (HIGH or LOW)
-     * @param loops amount of loops until timeout. Each loop lasts 10 microseconds
-     * @return amount of loops until signal found, or -1 for timeout
-     */
-    int16_t waitForSignal(int16_t signal, int16_t loops);
-
-
+    static DHTSensor* volatile mpTransferring;
 
     pin_t mPin;
+    int8_t mInterruptNo;
+    volatile uint8_t* mpInput;
+    uint8_t mBitMask;
+    volatile uint8_t mBits[5];
+    volatile uint8_t mEdges;
+    volatile uint16_t mRiseTime;
+    bool  mReadOK;
     bool  mLastReadOK;
+    int16_t mHumidity;
+    int16_t mTemperature;
+    time_t mSampleTime;
+    value_t mSampleIntervalInSeconds;
+    Task  mTask;
 };
 
 #endif // __DHTSENSOR_H
@@ -0,0 +1,223 @@
+/**
+ * ---------------------------------------------------------------------------------------------------
+ * This software is licensed under the GNU LESSER GENERAL PUBLIC LICENSE Version 3. It is furnished
+ * "as is", without any support, and with no warranty, express or implied, as to its usefulness for
+ * any purpose.
+ *
+ * File:      Diagnostics.cpp
+ *
+ * Author:    Volker Böhm
+ * Copyright: Volker Böhm
+ * Version:   1.0
+ * ---------------------------------------------------------------------------------------------------
+ */
+
+#include "Diagnostics.h"
+#include "Device.h"
+#include "Memory.h"
+#include "Schedule.h"
+#include "Profile.h"
+#include "PinEvents.h"
+#include "History.h"
+
+Diagnostics::Diagnostics()
+: NotifyTarget(0), mTopic(TOPIC_NONE), mAllProfiled(false), mItem(0), mMessage(0)
+{
+    NotifyTarget::setCheckMask(NotifyTarget::CHECKSTATE_NORMAL);
+    NotifyTarget::setPriority(NotifyTarget::PRIORITY_BACKGROUND);
+    NotifyTarget::unsubscribeAll();
+    NotifyTarget::subscribe(DIAGNOSTIC_KEY);
+}
+
+void Diagnostics::handleChange(address_t senderAddress, key_t key, StateValue data)
+{
+    if (key == DIAGNOSTIC_KEY) {
+        mTopic = data.toInt();
+        mItem = 0;
+        mMessage = 0;
+        if (mTopic == TOPIC_PROFILE) {
+            mAllProfiled = Schedule::startProfiling();
+        }
+    }
+}
+
+void Diagnostics::checkState(time_t scheduleLoops)
+{
+    if (mTopic != TOPIC_NONE && Device::getIOHandler()->maySend()) {
+        sendNextMessage();
+    }
+}
+
+void Diagnostics::sendNextMessage()
+{
+    value_t value;
+    if (mMessage == 0) {
+        // The first message of a record identifies the record
+        if (getRecordValue(mItem, 0, value)) {
+            value_t recordId = (value_t(mTopic) << 8) + mItem;
+            sendToServer(DIAGNOSTIC_ID_NOTIFICATION, recordId);
+            mMessage++;
+        } else {
+            mTopic = TOPIC_NONE;
+        }
+    } else if (getRecordValue(mItem, mMessage - 1, value)) {
+        sendToServer(DIAGNOSTIC_VALUE_NOTIFICATION, value);
+        mMessage++;
+    } else {
+        mItem++;
+        mMessage = 0;
+    }
+}
+
+bool Diagnostics::getRecordValue(uint8_t item, uint8_t field, value_t& value)
+{
+    bool result = false;
+    switch (mTopic) {
+        case TOPIC_MEMORY: result = getMemoryValue(item, field, value); break;
+        case TOPIC_PROFILE: result = getProfileValue(item, field, value); break;
+        case TOPIC_TICKS: result = getTicksValue(item, field, value); break;
+        case TOPIC_LOAD: result = getLoadValue(item, field, value); break;
+        case TOPIC_REPORTS: result = getReportsValue(item, field, value); break;
+        case TOPIC_EVENTS: result = getEventsValue(item, field, value); break;
+        default: break;
+    }
+    return result;
+}
+
+bool Diagnostics::getMemoryValue(uint8_t item, uint8_t field, value_t& value)
+{
+    bool result = true;
+    if (item == 0) {
+        switch (field) {
+            case 0: value = Trace::getFreeMemory(); break;
+            case 1: value = Memory::getUnusedStack(); break;
+            case 2: value = Memory::getHeapSize(); break;
+            case 3: value = Memory::getFreeListSize(); break;
+            case 4: value = Memory::getLargestFreeBlock(); break;
+            case 5: value = Memory::getFreeListBlocks(); break;
+            case 6: value = Memory::getStaticDataSize(); break;
+            default: result = false; break;
+        }
+    } else {
+        NotifyTarget* target = Schedule::getTarget(item - 1);
+        if (target == 0) {
+            result = false;
+        } else {
+            switch (field) {
+                case 0: value = target->getDeviceNo(); break;
+                case 1: value = target->getObjectSize(); break;
+                default: result = false; break;
+            }
+        }
+    }
+    return result;
+}
+
+bool Diagnostics::getProfileValue(uint8_t item, uint8_t field, value_t& value)
+{
+    bool result = true;
+    if (item == 0) {
+        if (field == 0) {
+            value = mAllProfiled ? 1 : 0;
+        } else {
+            result = false;
+        }
+    } else {
+        NotifyTarget* target = Schedule::getTarget(item - 1);
+        if (target == 0 || field > 12) {
+            result = false;
+        } else if (field == 0) {
+            value = target->getDeviceNo();
+        } else if (target->getProfile() == 0) {
+            value = 0;
+        } else {
+            const CallProfile* calls[] = {
+                &target->getProfile()->checkState,
+                &target->getProfile()->handleChange,
+                &target->getProfile()->notifyServer
+            };
+            const CallProfile* call = calls[(field - 1) / 4];
+            switch ((field - 1) % 4) {
+                case 0: value = call->getMin(); break;
+                case 1: value = call->getMax(); break;
+                case 2: value = call->getMean(); break;
+                default: value = call->getOverruns(); break;
+            }
+        }
+    }
+    return result;
+}
+
+bool Diagnostics::getTicksValue(uint8_t item, uint8_t field, value_t& value)
+{
+    bool result = field < TickHistogram::BUCKETS;
+    if (result && item == 0) {
+        value = Schedule::getLagHistogram().getCount(field);
+    } else if (result && item == 1) {
+        value = Schedule::getOverrunHistogram().getCount(field);
+    } else if (item == 2 && field == 0) {
+        value = Schedule::getDeferredCalls();
+    } else if (item == 2 && field == 1) {
+        value = Schedule::getDeferringTicks();
+    } else if (item == 3 && field == 0) {
+        value = PinEvents::getDispatched();
+    } else if (item == 3 && field == 1) {
+        value = PinEvents::getOverflows();
+    } else if (result && item == 4) {
+        value = PinEvents::getLatencyHistogram().getCount(field);
+    } else {
+        result = false;
+    }
+    return result;
+}
+
+bool Diagnostics::getLoadValue(uint8_t item, uint8_t field, value_t& value)
+{
+    bool result = true;
+    if (item == 0 && field < Schedule::LOAD_SLOTS) {
+        value_t load[Schedule::LOAD_SLOTS];
+        Schedule::getLoadProfile(load);
+        value = load[field];
+    } else if (item == 1 && field == 0) {
+        value = Schedule::getWorstLoadBeforeBalancing();
+    } else if (item == 1 && field == 1) {
+        value = Schedule::getWorstLoadAfterBalancing();
+    } else if (item == 2 && field == 0) {
+        value = Schedule::getHandleChangeCalls();
+    } else if (item == 2 && field == 1) {
+        value = Schedule::getHandleChangeSkips();
+    } else {
+        result = false;
+    }
+    return result;
+}
+
+bool Diagnostics::getReportsValue(uint8_t item, uint8_t field, value_t& value)
+{
+    bool result = item == 0;
+    const ReportQueue& queue = Schedule::getReportQueue();
+    switch (field) {
+        case 0: value = queue.getAmount(); break;
+        case 1: value = queue.getOldestAge(); break;
+        case 2: value = queue.getMaxAge(); break;
+        case 3: value = queue.getSent(); break;
+        case 4: value = queue.getRejected(); break;
+        case 5: value = History::getLost(); break;
+        default: result = false; break;
+    }
+    return result;
+}
+
+bool Diagnostics::getEventsValue(uint8_t item, uint8_t field, value_t& value)
+{
+    bool result = item == 0;
+    const EventQueue& queue = Schedule::getEventQueue();
+    switch (field) {
+        case 0: value = queue.getAmount(); break;
+        case 1: value = queue.getMaxAmount(); break;
+        case 2: value = queue.getDropped(); break;
+        case 3: value = Schedule::getEventBudget(); break;
+        default: result = false; break;
+    }
+    return result;
+}
@@ -0,0 +1,166 @@
+/**
+ * ---------------------------------------------------------------------------------------------------
+ * This software is licensed under the GNU LESSER GENERAL PUBLIC LICENSE Version 3. It is furnished
+ * "as is", without any support, and with no warranty, express or implied, as to its usefulness for
+ * any purpose.
+ *
+ * File:      Diagnostics.h
+ * Purpose:   Sends diagnostic dumps to the server. A dump is requested by sending DIAGNOSTIC_KEY with
+ *            the topic as value to device 0, example: {"R": 20, "K": "U", "V": 1}
+ *            A dump consists of records. Every record starts with a DIAGNOSTIC_ID_NOTIFICATION ('x')
+ *            having the topic in the high byte and the item number in the low byte. It is followed by
+ *            DIAGNOSTIC_VALUE_NOTIFICATION ('u') messages, one for each field of the record.
+ *            Only one message is sent per checkState call to not block the bus.
+ *
+ *            TOPIC_MEMORY
+ *            Item 0: free memory (heap/stack gap), unused stack (high-water mark), heap size,
+ *                    free list size, largest free block, free list blocks, static data size
+ *            Item n: n-th registered notify target: device number, object size in bytes
+ *
+ *            TOPIC_PROFILE (starts profiling on first request, see Schedule::startProfiling)
+ *            Item 0: 1 if all targets are profiled, 0 if memory was not sufficient
+ *            Item n: n-th registered notify target: device number, followed by minimum, maximum,
+ *                    moving average (all in microseconds) and overruns (calls > 10 ms) for
+ *                    checkState, handleChange and notifyServer (13 fields)
+ *
+ *            TOPIC_TICKS
+ *            Item 0: tick lag histogram, 8 buckets: < 1 ms, < 2 ms, < 4 ms, ... , >= 64 ms
+ *            Item 1: tick overrun histogram (time exceeding 10 ms), same buckets
+ *            Item 2: background calls deferred, ticks deferring background calls
+ *            Item 3: pin edges captured by interrupt and dispatched, edges lost due to a full buffer
+ *            Item 4: histogram of the time from pin edge to dispatch, same buckets
+ *
+ *            TOPIC_LOAD
+ *            Item 0: expected checkState load of 8 consecutive ticks in microseconds (see Schedule::getLoadProfile)
+ *            Item 1: highest load of a tick before phase balancing, highest load after phase balancing
+ *            Item 2: handleChange calls of received changes, calls saved by key subscriptions
+ *
+ *            TOPIC_REPORTS
+ *            Item 0: pending reports, age of the oldest pending report in milliseconds, longest time a
+ *                    report waited in milliseconds, reports sent, reports rejected (queue full),
+ *                    stored changes lost during a bus outage (see History.h)
+ *
+ *            TOPIC_EVENTS
+ *            Item 0: queued changes, highest amount of queued changes, changes dropped (queue full),
+ *                    changes delivered per tick (budget)
+ *
+ * Author:    Volker Böhm
+ * Copyright: Volker Böhm
+ * Version:   1.0
+ * ---------------------------------------------------------------------------------------------------
+ */
+
+#ifndef __DIAGNOSTICS_H
+#define __DIAGNOSTICS_H
+
+#include "StdInclude.h"
+
+class Diagnostics : public NotifyTarget {
+public:
+
+    typedef uint8_t topic_t;
+
+    static const topic_t TOPIC_NONE     = 0;
+    static const topic_t TOPIC_MEMORY   = 1;
+    static const topic_t TOPIC_PROFILE  = 2;
+    static const topic_t TOPIC_TICKS    = 3;
+    static const topic_t TOPIC_LOAD     = 4;
+    static const topic_t TOPIC_REPORTS  = 5;
+    static const topic_t TOPIC_EVENTS   = 6;
+
+    /**
+     * Creates the diagnostic handler. It belongs to device 0
+     */
+    Diagnostics();
+
+    /**
+     * Reacts on DIAGNOSTIC_KEY and starts a dump of the topic provided as value
+     * @param senderAddress address of the sender
+     * @param key key/identifier of the change
+     * @param data topic to dump
+     */
+    virtual void handleChange(address_t senderAddress, key_t key, StateValue data);
+
+    /**
+     * Sends the next message of a running dump, if the device may send
+     * @param scheduleLoops number of checkState loops since reboot
+     */
+    virtual void checkState(time_t scheduleLoops);
+
+private:
+
+    /**
+     * Sends the next message of the current dump. Ends the dump, if all records are sent
+     */
+    void sendNextMessage();
+
+    /**
+     * Gets a field value of a record of the current topic
+     * @param item item number of the record
+     * @param field index of the field in the record
+     * @param value output: value of the field
+     * @return true, if the field exists
+     */
+    bool getRecordValue(uint8_t item, uint8_t field, value_t& value);
+
+    /**
+     * Gets a field value of a record of topic TOPIC_MEMORY
+     * @param item item number of the record
+     * @param field index of the field in the record
+     * @param value output: value of the field
+     * @return true, if the field exists
+     */
+    bool getMemoryValue(uint8_t item, uint8_t field, value_t& value);
+
+    /**
+     * Gets a field value of a record of topic TOPIC_PROFILE
+     * @param item item number of the record
+     * @param field index of the field in the record
+     * @param value output: value of the field
+     * @return true, if the field exists
+     */
+    bool getProfileValue(uint8_t item, uint8_t field, value_t& value);
+
+    /**
+     * Gets a field value of a record of topic TOPIC_TICKS
+     * @param item item number of the record
+     * @param field index of the field in the record
+     * @param value output: value of the field
+     * @return true, if the field exists
+     */
+    bool getTicksValue(uint8_t item, uint8_t field, value_t& value);
+
+    /**
+     * Gets a field value of a record of topic TOPIC_LOAD
+     * @param item item number of the record
+     * @param field index of the field in the record
+     * @param value output: value of the field
+     * @return true, if the field exists
+     */
+    bool getLoadValue(uint8_t item, uint8_t field, value_t& value);
+
+    /**
+     * Gets a field value of a record of topic TOPIC_REPORTS
+     * @param item item number of the record
+     * @param field index of the field in the record
+     * @param value output: value of the field
+     * @return true, if the field exists
+     */
+    bool getReportsValue(uint8_t item, uint8_t field, value_t& value);
+
+    /**
+     * Gets a field value of a record of topic TOPIC_EVENTS
+     * @param item item number of the record
+     * @param field index of the field in the record
+     * @param value output: value of the field
+     * @return true, if the field exists
+     */
+    bool getEventsValue(uint8_t item, uint8_t field, value_t& value);
+
+    topic_t mTopic;
+    bool    mAllProfiled;
+    uint8_t mItem;
+    uint8_t mMessage;
+};
+
+#endif // __DIAGNOSTICS_H
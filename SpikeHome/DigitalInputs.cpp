@@ -0,0 +1,71 @@
+/**
+ * ---------------------------------------------------------------------------------------------------
+ * This software is licensed under the GNU LESSER GENERAL PUBLIC LICENSE Version 3. It is furnished
+ * "as is", without any support, and with no warranty, express or implied, as to its usefulness for
+ * any purpose.
+ *
+ * File:      DigitalInputs.cpp
+ *
+ * Author:    Volker Böhm
+ * Copyright: Volker Böhm
+ * Version:   1.0
+ * ---------------------------------------------------------------------------------------------------
+ */
+
+#include "DigitalInputs.h"
+
+volatile uint8_t*   DigitalInputs::mpInput[MAX_PORTS];
+uint8_t             DigitalInputs::mMask[MAX_PORTS];
+uint8_t             DigitalInputs::mState[MAX_PORTS];
+uint8_t             DigitalInputs::mCount0[MAX_PORTS];
+uint8_t             DigitalInputs::mCount1[MAX_PORTS];
+uint8_t             DigitalInputs::mPorts;
+
+uint8_t DigitalInputs::getPortIndex(volatile uint8_t* pInput)
+{
+    for (uint8_t index = 0; index < mPorts; index++) {
+        if (mpInput[index] == pInput) {
+            return index;
+        }
+    }
+    uint8_t result = NOT_FOUND;
+    if (mPorts < MAX_PORTS) {
+        result = mPorts;
+        mpInput[result] = pInput;
+        mMask[result] = 0;
+        // Counters at rest are all ones
+        mCount0[result] = 0xFF;
+        mCount1[result] = 0xFF;
+        mPorts++;
+    }
+    return result;
+}
+
+uint8_t DigitalInputs::read(pin_t pin)
+{
+    volatile uint8_t* pInput = portInputRegister(digitalPinToPort(pin));
+    uint8_t bit = digitalPinToBitMask(pin);
+    uint8_t index = getPortIndex(pInput);
+    if (index == NOT_FOUND) {
+        return (*pInput & bit) != 0 ? HIGH : LOW;
+    }
+    if ((mMask[index] & bit) == 0) {
+        mMask[index] |= bit;
+        mState[index] = (mState[index] & ~bit) | (*pInput & bit);
+    }
+    return (mState[index] & bit) != 0 ? HIGH : LOW;
+}
+
+void DigitalInputs::sample()
+{
+    for (uint8_t index = 0; index < mPorts; index++) {
+        // Bits of registered pins having a level different from the debounced level
+        uint8_t changed = (mState[index] ^ *mpInput[index]) & mMask[index];
+        // Counts down every changed pin, resets the counters of all other pins
+        mCount0[index] = ~(mCount0[index] & changed);
+        mCount1[index] = mCount0[index] ^ (mCount1[index] & changed);
+        // Toggles the pins whose counter rolled over
+        changed &= mCount0[index] & mCount1[index];
+        mState[index] ^= changed;
+    }
+}
@@ -0,0 +1,74 @@
+/**
+ * ---------------------------------------------------------------------------------------------------
+ * This software is licensed under the GNU LESSER GENERAL PUBLIC LICENSE Version 3. It is furnished
+ * "as is", without any support, and with no warranty, express or implied, as to its usefulness for
+ * any purpose.
+ *
+ * File:      DigitalInputs.h
+ * Purpose:   Debounced digital inputs. The schedule reads the input registers of all ports with
+ *            registered pins once per tick (snapshot). Every pin has a two bit vertical counter, the
+ *            counters of the eight pins of a port are updated in parallel by a few bit operations.
+ *            The debounced level changes after the pin had the new level for DEBOUNCE_TICKS
+ *            consecutive ticks (40 ms), shorter pulses like contact bounces are ignored.
+ *            A pin is registered by its first read (see read), the cost per tick depends on the amount
+ *            of ports only.
+ *
+ * Author:    Volker Böhm
+ * Copyright: Volker Böhm
+ * Version:   1.0
+ * ---------------------------------------------------------------------------------------------------
+ */
+
+#ifndef __DIGITALINPUTS_H
+#define __DIGITALINPUTS_H
+
+#include "StdInclude.h"
+
+class DigitalInputs {
+public:
+
+    /**
+     * Maximal amount of ports sampled, the ATmega328 has three ports (B, C, D)
+     */
+    static const uint8_t MAX_PORTS = 3;
+
+    /**
+     * Amount of consecutive ticks a pin must have a new level (given by the two bit counter)
+     */
+    static const uint8_t DEBOUNCE_TICKS = 4;
+
+    /**
+     * Reads the debounced level of a digital pin. Registers the pin on the first read, the first
+     * read returns the current level of the pin. Pins of further ports are read directly.
+     * @param pin digital pin
+     * @return HIGH or LOW
+     */
+    static uint8_t read(pin_t pin);
+
+    /**
+     * Reads the input registers of all ports and debounces the registered pins, called by the
+     * schedule every tick
+     */
+    static void sample();
+
+private:
+    DigitalInputs() {}
+
+    static const uint8_t NOT_FOUND = 0xFF;
+
+    /**
+     * Gets the index of a port, adds the port if it is not yet sampled
+     * @param pInput input register of the port
+     * @return index of the port, NOT_FOUND if all ports are used
+     */
+    static uint8_t getPortIndex(volatile uint8_t* pInput);
+
+    static volatile uint8_t*    mpInput[MAX_PORTS];
+    static uint8_t              mMask[MAX_PORTS];
+    static uint8_t              mState[MAX_PORTS];
+    static uint8_t              mCount0[MAX_PORTS];
+    static uint8_t              mCount1[MAX_PORTS];
+    static uint8_t              mPorts;
+};
+
+#endif // __DIGITALINPUTS_H
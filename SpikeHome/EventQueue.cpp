@@ -0,0 +1,42 @@
+/**
+ * ---------------------------------------------------------------------------------------------------
+ * This software is licensed under the GNU LESSER GENERAL PUBLIC LICENSE Version 3. It is furnished
+ * "as is", without any support, and with no warranty, express or implied, as to its usefulness for
+ * any purpose.
+ *
+ * File:      EventQueue.cpp
+ *
+ * Author:    Volker Böhm
+ * Copyright: Volker Böhm
+ * Version:   1.0
+ * ---------------------------------------------------------------------------------------------------
+ */
+
+#include "EventQueue.h"
+
+bool EventQueue::add(device_t deviceNo, key_t key, StateValue value)
+{
+    bool result = mAmount < SIZE;
+    if (result) {
+        Event& event = mEvents[(mFirst + mAmount) % SIZE];
+        event.deviceNo = deviceNo;
+        event.key = key;
+        event.value = value;
+        mAmount++;
+        mMaxAmount = max(mMaxAmount, mAmount);
+    } else if (mDropped < MAX_COUNT) {
+        mDropped++;
+    }
+    return result;
+}
+
+bool EventQueue::remove(Event& event)
+{
+    bool result = mAmount > 0;
+    if (result) {
+        event = mEvents[mFirst];
+        mFirst = (mFirst + 1) % SIZE;
+        mAmount--;
+    }
+    return result;
+}
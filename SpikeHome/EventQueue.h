@@ -0,0 +1,83 @@
+/**
+ * ---------------------------------------------------------------------------------------------------
+ * This software is licensed under the GNU LESSER GENERAL PUBLIC LICENSE Version 3. It is furnished
+ * "as is", without any support, and with no warranty, express or implied, as to its usefulness for
+ * any purpose.
+ *
+ * File:      EventQueue.h
+ * Purpose:   Queue of changes posted by notify and notifyAllDevices (see NotifyTarget). The schedule
+ *            delivers the changes once per tick. A handleChange call posting further changes
+ *            does not call handleChange recursively, thus the stack depth is bounded.
+ *            The queue has a fixed size, changes posted to a full queue are dropped and counted.
+ *
+ * Author:    Volker Böhm
+ * Copyright: Volker Böhm
+ * Version:   1.0
+ * ---------------------------------------------------------------------------------------------------
+ */
+
+#ifndef __EVENTQUEUE_H
+#define __EVENTQUEUE_H
+
+#include "StdInclude.h"
+
+class EventQueue {
+public:
+
+    static const uint8_t  SIZE        = 16;
+    static const uint16_t MAX_COUNT   = 0xFFFF;
+
+    /**
+     * Device number of changes for all devices
+     */
+    static const device_t ALL_DEVICES = -1;
+
+    struct Event {
+        device_t   deviceNo;
+        key_t      key;
+        StateValue value;
+    };
+
+    EventQueue() : mFirst(0), mAmount(0), mMaxAmount(0), mDropped(0) {}
+
+    /**
+     * Adds a change to the end of the queue
+     * @param deviceNo number of the device to notify, ALL_DEVICES for all devices
+     * @param key key/identifier of the change
+     * @param value new value
+     * @return true, if the change is queued, false if the queue is full
+     */
+    bool add(device_t deviceNo, key_t key, StateValue value);
+
+    /**
+     * Removes the oldest change from the queue
+     * @param event output: the change removed
+     * @return true, if a change was queued
+     */
+    bool remove(Event& event);
+
+    /**
+     * Gets the amount of queued changes
+     */
+    uint8_t getAmount() const { return mAmount; }
+
+    /**
+     * Gets the highest amount of changes queued at the same time
+     */
+    uint8_t getMaxAmount() const { return mMaxAmount; }
+
+    /**
+     * Gets the amount of changes dropped because the queue was full
+     * @return amount of changes (saturates at 65535)
+     */
+    uint16_t getDropped() const { return mDropped; }
+
+private:
+    Event    mEvents[SIZE];
+    uint8_t  mFirst;
+    uint8_t  mAmount;
+    uint8_t  mMaxAmount;
+    uint16_t mDropped;
+};
+
+#endif // __EVENTQUEUE_H
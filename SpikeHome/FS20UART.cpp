@@ -17,23 +17,33 @@
 
 #include "FS20UART.h"
 #include "Device.h"
+#include "Schedule.h"
 
 FS20UART::FS20UART(device_t deviceNo, pin_t rxPin, pin_t txPin)
 :NotifyTarget(deviceNo), mState(STATE_WAITING), mReceiverAddress(0)
 {
     mpSerial = new SoftwareSerial(rxPin, txPin);
     mpSerial->begin(4800);
-    delay(100);
+    NotifyTarget::setCheckMask(NotifyTarget::CHECKSTATE_ALLWAYS);
+    NotifyTarget::setPriority(NotifyTarget::PRIORITY_CRITICAL);
+    NotifyTarget::unsubscribeAll();
+}
+
+bool FS20UART::runSetup()
+{
+    TASK_BEGIN(mSetupTask);
+    TASK_WAIT_MS(mSetupTask, WAIT_FOR_UART_IN_MILLISECONDS);
     enableFS20Data();
+    TASK_WAIT_MS(mSetupTask, WAIT_AFTER_COMMAND_IN_MILLISECONDS);
     getStats();
-    NotifyTarget::setCheckMask(NotifyTarget::CHECKSTATE_ALLWAYS);
+    TASK_WAIT_MS(mSetupTask, WAIT_AFTER_COMMAND_IN_MILLISECONDS);
+    TASK_END(mSetupTask);
 }
 
 void FS20UART::getStats()
 {
      // Returns status of weather data receiver
     mpSerial->print(F("\x02\x01\xF0"));
-    delay(10);
 }
 
 
@@ -41,7 +51,6 @@ void FS20UART::enableFS20Data()
 {
     // Receive FS20 data and transmit immediately
     mpSerial->print(F("\x02\x02\xF1\x01"));
-    delay(10);
 }
 
 
@@ -49,13 +58,11 @@ void FS20UART::enableWeatherData()
 {
     // Receive weather data and transmit immediately
     mpSerial->print(F("\x02\x02\xF2\x01"));
-    delay(10);
 }
 
 void FS20UART::enableTextMode()
 {
     mpSerial->print(F("\x02\x02\xFB\x01"));
-    delay(10);
 
 }
 
@@ -97,11 +104,11 @@ void FS20UART::handleCommand(address_t address, value_t command)
     if (deviceNo != -1) {
         if ((command & 3) == 3) {
             for (deviceNo = 0; deviceNo < Device::getDeviceAmount(); deviceNo++) {
-                Device::getNotify(deviceNo).change(FS20_COMMMAND, command);
+                Schedule::postChange(deviceNo, FS20_COMMMAND, command);
             }
         } else {
             printVariableIfDebug(command);
-            Device::getNotify(deviceNo).change(FS20_COMMMAND, command);
+            Schedule::postChange(deviceNo, FS20_COMMMAND, command);
         }
     } else {
         mReceiverAddress = address;
@@ -164,6 +171,9 @@ void FS20UART::scanReply()
 
 void FS20UART::checkState(uint32_t scheduleLoops)
 {
+    if (runSetup()) {
+        return;
+    }
     if (mReceiverAddress != 0) {
         if (sendToAddress(FS20_COMMMAND, mCommand, mReceiverAddress)) {
             mReceiverAddress = 0;
@@ -16,6 +16,7 @@
  */
 
 #include "NotifyTarget.h"
+#include "Task.h"
 
 class SoftwareSerial;
 
@@ -44,6 +45,13 @@ public:
 
 private:
 
+    /**
+     * Sends the setup commands to the UART. The UART needs WAIT_AFTER_COMMAND_IN_MILLISECONDS after
+     * every command
+     * @return true, while the setup is running
+     */
+    bool runSetup();
+
     /**
      * Wether data receiving enabled
      */
@@ -111,6 +119,9 @@ private:
     static const uint16_t HC1 = FS20_CONV(1232);
     static const uint16_t HC2 = FS20_CONV(2323);
 
+    static const time_t WAIT_FOR_UART_IN_MILLISECONDS = 100;
+    static const time_t WAIT_AFTER_COMMAND_IN_MILLISECONDS = 10;
+
     static const uint8_t STATE_WAITING = 0;
     static const uint8_t STATE_CHAR_RECEIVED = 1;
 
@@ -118,5 +129,6 @@ private:
     uint8_t     mState;
     key_t       mCommand;
     address_t   mReceiverAddress;
+    Task        mSetupTask;
 
 };
@@ -0,0 +1,231 @@
+/**
+ * ---------------------------------------------------------------------------------------------------
+ * This software is licensed under the GNU LESSER GENERAL PUBLIC LICENSE Version 3. It is furnished
+ * "as is", without any support, and with no warranty, express or implied, as to its usefulness for
+ * any purpose.
+ *
+ * File:      Fade.cpp
+ *
+ * Author:    Volker Böhm
+ * Copyright: Volker Böhm
+ * Version:   1.0
+ * ---------------------------------------------------------------------------------------------------
+ */
+
+#include "Fade.h"
+#include <avr/pgmspace.h>
+
+/**
+ * Duty cycle of the levels 0 .. 255: PWM_TOP * (level / 255) ^ 2.2
+ */
+static const uint16_t GAMMA_TABLE[Fade::MAX_LEVEL + 1] PROGMEM = {
+        0,     0,     0,     1,     2,     3,     4,     6,     8,    10,    13,    16,
+       20,    23,    28,    32,    37,    42,    48,    54,    61,    67,    75,    82,
+       90,    99,   108,   117,   127,   137,   148,   159,   170,   182,   195,   207,
+      221,   234,   249,   263,   278,   294,   310,   326,   343,   361,   379,   397,
+      416,   435,   455,   475,   496,   517,   539,   561,   583,   607,   630,   654,
+      679,   704,   730,   756,   783,   810,   838,   866,   894,   924,   953,   983,
+     1014,  1045,  1077,  1110,  1142,  1176,  1210,  1244,  1279,  1314,  1350,  1387,
+     1424,  1461,  1499,  1538,  1577,  1617,  1657,  1698,  1739,  1781,  1823,  1866,
+     1910,  1954,  1998,  2044,  2089,  2136,  2182,  2230,  2278,  2326,  2375,  2425,
+     2475,  2525,  2577,  2629,  2681,  2734,  2787,  2841,  2896,  2951,  3007,  3063,
+     3120,  3178,  3236,  3295,  3354,  3414,  3474,  3535,  3596,  3658,  3721,  3784,
+     3848,  3913,  3978,  4043,  4110,  4176,  4244,  4312,  4380,  4449,  4519,  4589,
+     4660,  4732,  4804,  4876,  4950,  5024,  5098,  5173,  5249,  5325,  5402,  5479,
+     5557,  5636,  5715,  5795,  5876,  5957,  6039,  6121,  6204,  6287,  6372,  6456,
+     6542,  6628,  6714,  6801,  6889,  6978,  7067,  7156,  7247,  7337,  7429,  7521,
+     7614,  7707,  7801,  7896,  7991,  8087,  8183,  8281,  8378,  8477,  8576,  8675,
+     8775,  8876,  8978,  9080,  9183,  9286,  9390,  9495,  9600,  9706,  9812,  9920,
+    10027, 10136, 10245, 10355, 10465, 10576, 10688, 10800, 10913, 11027, 11141, 11256,
+    11371, 11487, 11604, 11721, 11840, 11958, 12078, 12198, 12318, 12440, 12562, 12684,
+    12807, 12931, 13056, 13181, 13307, 13433, 13561, 13688, 13817, 13946, 14076, 14206,
+    14337, 14469, 14602, 14735, 14868, 15003, 15138, 15273, 15410, 15547, 15685, 15823,
+    15962, 16102, 16242, 16383
+};
+
+Fade::Channel       Fade::mChannel[MAX_CHANNELS];
+uint8_t             Fade::mChannels;
+
+ISR(TIMER1_OVF_vect)
+{
+    Fade::onTimer();
+}
+
+void Fade::onTimer()
+{
+    bool active = false;
+    for (uint8_t index = 0; index < mChannels; index++) {
+        Channel& channel = mChannel[index];
+        if (channel.level != channel.target) {
+            if (channel.level < channel.target) {
+                channel.level = channel.target - channel.level > channel.step ?
+                    channel.level + channel.step : channel.target;
+            } else {
+                channel.level = channel.level - channel.target > channel.step ?
+                    channel.level - channel.step : channel.target;
+            }
+            channel.duty = toDuty(channel.level);
+            active = true;
+        }
+        if (output(channel)) {
+            active = true;
+        }
+    }
+    if (!active) {
+        TIMSK1 &= ~_BV(TOIE1);
+    }
+}
+
+uint16_t Fade::toDuty(uint16_t level)
+{
+    uint8_t index = level >> FRACTION_BITS;
+    uint8_t fraction = level & ((1 << FRACTION_BITS) - 1);
+    uint16_t duty = pgm_read_word(&GAMMA_TABLE[index]);
+    if (fraction != 0) {
+        // The largest difference of two neighbours is 141, the product fits into 16 bits
+        uint16_t next = pgm_read_word(&GAMMA_TABLE[index + 1]);
+        duty += uint16_t((next - duty) * fraction) >> FRACTION_BITS;
+    }
+    return duty;
+}
+
+bool Fade::output(Channel& channel)
+{
+    uint16_t duty = channel.duty;
+    bool dithering = false;
+    if (channel.pCompare16 != 0) {
+        *channel.pCompare16 = duty;
+    } else {
+        // Error diffusion: the remainder of the 6 lower bits is carried to the next PWM period
+        channel.dither += duty & DITHER_MASK;
+        duty >>= DITHER_BITS;
+        if (channel.dither > DITHER_MASK) {
+            channel.dither -= DITHER_MASK + 1;
+            if (duty < 0xFF) {
+                duty++;
+            }
+        }
+        *channel.pCompare8 = uint8_t(duty);
+        dithering = (channel.duty & DITHER_MASK) != 0;
+    }
+    // A compare value of 0 still produces a short spike in fast PWM mode
+    if (duty == 0) {
+        *channel.pControl &= ~channel.connectBit;
+    } else {
+        *channel.pControl |= channel.connectBit;
+    }
+    return dithering;
+}
+
+bool Fade::connect(Channel& channel, pin_t pin)
+{
+    channel.pCompare16 = 0;
+    channel.pCompare8 = 0;
+    switch (digitalPinToTimer(pin)) {
+        case TIMER1A: channel.pCompare16 = &OCR1A; channel.pControl = &TCCR1A; channel.connectBit = _BV(COM1A1); break;
+        case TIMER1B: channel.pCompare16 = &OCR1B; channel.pControl = &TCCR1A; channel.connectBit = _BV(COM1B1); break;
+        case TIMER0A: channel.pCompare8 = &OCR0A; channel.pControl = &TCCR0A; channel.connectBit = _BV(COM0A1); break;
+        case TIMER0B: channel.pCompare8 = &OCR0B; channel.pControl = &TCCR0A; channel.connectBit = _BV(COM0B1); break;
+#if defined(TCCR2A) && defined(COM2A1)
+        case TIMER2A: channel.pCompare8 = &OCR2A; channel.pControl = &TCCR2A; channel.connectBit = _BV(COM2A1);
+            startTimer2(); break;
+        case TIMER2B: channel.pCompare8 = &OCR2B; channel.pControl = &TCCR2A; channel.connectBit = _BV(COM2B1);
+            startTimer2(); break;
+#endif
+        default: return false;
+    }
+    return true;
+}
+
+void Fade::startTimer2()
+{
+#if defined(TCCR2A) && defined(WGM21)
+    // Fast PWM with prescaler 64: one PWM period per Timer1 overflow, like Timer0 set up by the Arduino core.
+    // In the phase correct mode of the core (490 Hz) every second dithered compare value would be lost.
+    TCCR2A |= _BV(WGM21) | _BV(WGM20);
+    TCCR2B = (TCCR2B & ~(_BV(WGM22) | _BV(CS22) | _BV(CS21) | _BV(CS20))) | _BV(CS22);
+#endif
+}
+
+void Fade::startTimer()
+{
+    // Mode 14: fast PWM with ICR1 as top, no prescaler
+    TCCR1B = 0;
+    TCCR1A = (TCCR1A & (_BV(COM1A1) | _BV(COM1B1))) | _BV(WGM11);
+    ICR1 = PWM_TOP;
+    TCNT1 = 0;
+    TCCR1B = _BV(WGM13) | _BV(WGM12) | _BV(CS10);
+}
+
+uint8_t Fade::attach(pin_t pin)
+{
+    if (mChannels >= MAX_CHANNELS) {
+        return NO_CHANNEL;
+    }
+    Channel& channel = mChannel[mChannels];
+    if (!connect(channel, pin)) {
+        return NO_CHANNEL;
+    }
+    // The output is low while the PWM is disconnected
+    digitalWrite(pin, LOW);
+    pinMode(pin, OUTPUT);
+    channel.level = 0;
+    channel.target = 0;
+    channel.step = 0;
+    channel.duty = 0;
+    channel.dither = 0;
+
+    uint8_t oldSREG = SREG;
+    cli();
+    if (mChannels == 0) {
+        startTimer();
+    }
+    mChannels++;
+    SREG = oldSREG;
+    return mChannels - 1;
+}
+
+void Fade::start(uint8_t channel, uint8_t level, uint16_t durationInMilliseconds)
+{
+    if (channel >= mChannels) {
+        return;
+    }
+    Channel& cur = mChannel[channel];
+    uint16_t target = uint16_t(level) << FRACTION_BITS;
+    uint32_t ticks = uint32_t(durationInMilliseconds) * TICKS_PER_SECOND / 1000;
+
+    uint8_t oldSREG = SREG;
+    cli();
+    uint16_t distance = target > cur.level ? target - cur.level : cur.level - target;
+    cur.target = target;
+    cur.step = ticks == 0 ? distance : uint16_t(distance / ticks);
+    if (cur.step == 0) {
+        cur.step = 1;
+    }
+    TIMSK1 |= _BV(TOIE1);
+    SREG = oldSREG;
+}
+
+uint8_t Fade::getLevel(uint8_t channel)
+{
+    if (channel >= mChannels) {
+        return 0;
+    }
+    uint8_t oldSREG = SREG;
+    cli();
+    uint16_t level = mChannel[channel].level;
+    SREG = oldSREG;
+    return level >> FRACTION_BITS;
+}
+
+bool Fade::isFading(uint8_t channel)
+{
+    if (channel >= mChannels) {
+        return false;
+    }
+    uint8_t oldSREG = SREG;
+    cli();
+    bool fading = mChannel[channel].level != mChannel[channel].target;
+    SREG = oldSREG;
+    return fading;
+}
@@ -0,0 +1,156 @@
+/**
+ * ---------------------------------------------------------------------------------------------------
+ * This software is licensed under the GNU LESSER GENERAL PUBLIC LICENSE Version 3. It is furnished
+ * "as is", without any support, and with no warranty, express or implied, as to its usefulness for
+ * any purpose.
+ *
+ * File:      Fade.h
+ * Purpose:   Interrupt driven fade engine for PWM outputs. A fade moves the level of a channel to a
+ *            target level within a duration, the caller issues the command once and the timer interrupt
+ *            does the rest. Levels (0 .. MAX_LEVEL) are perceptual, they are mapped to the PWM duty
+ *            cycle by a gamma table (gamma 2.2) stored in flash. Between two levels the duty cycle is
+ *            interpolated, thus a slow fade shows no visible steps, even at the low end.
+ *            The engine owns Timer1: it runs in 14 bit fast PWM mode (PWM_TOP), its overflow interrupt
+ *            (976 Hz at 16 MHz) advances the fades. The Timer1 pins (9 and 10 on the Uno) get the full
+ *            14 bit resolution. Timer0 and Timer2 pins keep their 8 bit PWM, the missing 6 bits are
+ *            added by dithering the compare value from one PWM period to the next. Dithering needs one
+ *            PWM period per interrupt: Timer0 runs in fast PWM with prescaler 64 (976 Hz) by the Arduino
+ *            core, Timer2 is switched from phase correct to the same mode when a Timer2 pin is attached.
+ *            This changes the PWM frequency of the other Timer2 pin to 976 Hz as well.
+ *            The interrupt is disabled while no channel is fading or dithering. A level with a duty
+ *            cycle that is no multiple of 64 is dithered as long as it is shown, thus the interrupt
+ *            stays enabled and wakes the idle sleep of the schedule at 976 Hz. The Timer0 interrupt
+ *            of millis wakes it at the same rate anyway, the dithering adds a few microseconds per tick.
+ *            Do not use analogWrite on a channel pin or on the Timer1 pins once a channel is attached.
+ *
+ * Author:    Volker Böhm
+ * Copyright: Volker Böhm
+ * Version:   1.0
+ * ---------------------------------------------------------------------------------------------------
+ */
+
+#ifndef __FADE_H
+#define __FADE_H
+
+#include "StdInclude.h"
+
+class Fade {
+public:
+
+    /**
+     * Maximal amount of channels
+     */
+    static const uint8_t MAX_CHANNELS = 2;
+
+    static const uint8_t NO_CHANNEL = 0xFF;
+
+    /**
+     * Highest level, level 0 switches the output off
+     */
+    static const uint8_t MAX_LEVEL = 255;
+
+    /**
+     * Top value of Timer1, the maximal duty cycle
+     */
+    static const uint16_t PWM_TOP = 0x3FFF;
+
+    /**
+     * Timer interrupts per second, every interrupt advances the fades by one step
+     */
+    static const uint32_t TICKS_PER_SECOND = F_CPU / (PWM_TOP + 1UL);
+
+    /**
+     * Attaches a PWM pin to the engine. The output is off after attaching.
+     * @param pin PWM pin on Timer0, Timer1 or Timer2
+     * @return channel of the pin, NO_CHANNEL if the pin has no supported PWM or all channels are used
+     */
+    static uint8_t attach(pin_t pin);
+
+    /**
+     * Starts a fade from the current level to a target level, a running fade is replaced
+     * @param channel channel of the output (see attach)
+     * @param level target level 0 .. MAX_LEVEL
+     * @param durationInMilliseconds duration of the fade, 0 = set the level on the next timer interrupt
+     */
+    static void start(uint8_t channel, uint8_t level, uint16_t durationInMilliseconds);
+
+    /**
+     * Gets the current level of a channel, rounded down while fading
+     * @param channel channel of the output
+     * @return level 0 .. MAX_LEVEL
+     */
+    static uint8_t getLevel(uint8_t channel);
+
+    /**
+     * Checks, if a channel has not yet reached its target level
+     * @param channel channel of the output
+     */
+    static bool isFading(uint8_t channel);
+
+    /**
+     * Interrupt handler of the Timer1 overflow
+     */
+    static void onTimer();
+
+private:
+    Fade() {}
+
+    /**
+     * Levels are stored with 8 fractional bits
+     */
+    static const uint8_t  FRACTION_BITS = 8;
+    /**
+     * Amount of duty cycle bits dithered on 8 bit PWM outputs
+     */
+    static const uint8_t  DITHER_BITS = 6;
+    static const uint8_t  DITHER_MASK = (1 << DITHER_BITS) - 1;
+
+    struct Channel {
+        volatile uint16_t* pCompare16;
+        volatile uint8_t*  pCompare8;
+        volatile uint8_t*  pControl;
+        uint8_t            connectBit;
+        uint16_t           level;
+        uint16_t           target;
+        uint16_t           step;
+        uint16_t           duty;
+        uint8_t            dither;
+    };
+
+    /**
+     * Sets the compare and control registers of a pin
+     * @param channel channel to initialize
+     * @param pin PWM pin
+     * @return true, if the pin has a supported PWM
+     */
+    static bool connect(Channel& channel, pin_t pin);
+
+    /**
+     * Configures Timer1 to 14 bit fast PWM
+     */
+    static void startTimer();
+
+    /**
+     * Configures Timer2 to 8 bit fast PWM at the frequency of the Timer1 overflow
+     */
+    static void startTimer2();
+
+    /**
+     * Maps a level to the duty cycle by the gamma table
+     * @param level level with FRACTION_BITS fractional bits
+     * @return duty cycle 0 .. PWM_TOP
+     */
+    static uint16_t toDuty(uint16_t level);
+
+    /**
+     * Writes the duty cycle of a channel to its compare register, switches the output off on 0
+     * @param channel channel to write
+     * @return true, if the channel needs further interrupts for dithering
+     */
+    static bool output(Channel& channel);
+
+    static Channel          mChannel[MAX_CHANNELS];
+    static uint8_t          mChannels;
+};
+
+#endif // __FADE_H
@@ -0,0 +1,133 @@
+/**
+ * ---------------------------------------------------------------------------------------------------
+ * This software is licensed under the GNU LESSER GENERAL PUBLIC LICENSE Version 3. It is furnished
+ * "as is", without any support, and with no warranty, express or implied, as to its usefulness for
+ * any purpose.
+ *
+ * File:      History.cpp
+ *
+ * Author:    Volker Böhm
+ * Copyright: Volker Böhm
+ * Version:   1.0
+ * ---------------------------------------------------------------------------------------------------
+ */
+
+#include "History.h"
+#include "Device.h"
+
+History::Entry  History::mEntries[SIZE];
+uint8_t         History::mHead;
+uint8_t         History::mAmount;
+uint8_t         History::mUnsent;
+time_t          History::mLastTimeInSeconds;
+uint16_t        History::mLost;
+
+History::History()
+: NotifyTarget(0), mAgeSent(false), mQueryKey(0), mQueryIndex(NO_QUERY)
+{
+    NotifyTarget::setCheckMask(NotifyTarget::CHECKSTATE_NORMAL);
+    NotifyTarget::setPriority(NotifyTarget::PRIORITY_BACKGROUND);
+    NotifyTarget::unsubscribeAll();
+    NotifyTarget::subscribe(HISTORY_KEY);
+}
+
+void History::record(device_t deviceNo, key_t key, value_t value)
+{
+    if (key == 0 || Device::getIOHandler()->isConnected()) {
+        return;
+    }
+    time_t nowInSeconds = millis() / MILLISECONDS_IN_A_SECOND;
+    time_t timeDelta = mAmount == 0 ? 0 : nowInSeconds - mLastTimeInSeconds;
+    if (timeDelta > MAX_TIME_DELTA) {
+        timeDelta = MAX_TIME_DELTA;
+    }
+    Entry& entry = mEntries[mHead];
+    entry.key = key;
+    entry.deviceAndTimeDelta = (uint16_t(deviceNo) << DEVICE_SHIFT) | uint16_t(timeDelta);
+    entry.value = value;
+    mHead = (mHead + 1) % SIZE;
+    mLastTimeInSeconds = nowInSeconds;
+    if (mAmount < SIZE) {
+        mAmount++;
+    }
+    if (mUnsent < SIZE) {
+        mUnsent++;
+    } else if (mLost < MAX_COUNT) {
+        mLost++;
+    }
+}
+
+void History::handleChange(address_t senderAddress, key_t key, StateValue data)
+{
+    if (key == HISTORY_KEY) {
+        value_t query = data.toInt();
+        mQueryKey = query & 0xFF;
+        uint8_t amount = query >> 8;
+        // Walks back from the newest entry to the first entry to send
+        mQueryIndex = NO_QUERY;
+        for (uint8_t index = mAmount; index > 0; index--) {
+            if (getEntry(index - 1).key == mQueryKey) {
+                mQueryIndex = index - 1;
+                if (amount == 1) {
+                    break;
+                }
+                if (amount > 1) {
+                    amount--;
+                }
+            }
+        }
+        mAgeSent = false;
+        checkAgainIn(0);
+    }
+}
+
+void History::checkState(time_t scheduleLoops)
+{
+    SerialIO* pIOHandler = Device::getIOHandler();
+    if (!pIOHandler->isConnected() || !pIOHandler->maySend()) {
+        return;
+    }
+    if (mUnsent > 0) {
+        if (sendEntry(mAmount - mUnsent)) {
+            mUnsent--;
+        }
+        checkAgainIn(1);
+    } else if (mQueryIndex != NO_QUERY) {
+        if (sendEntry(mQueryIndex)) {
+            mQueryIndex = findQueryEntry(mQueryIndex + 1);
+        }
+        checkAgainIn(1);
+    }
+}
+
+value_t History::getAge(uint8_t index)
+{
+    time_t age = millis() / MILLISECONDS_IN_A_SECOND - mLastTimeInSeconds;
+    for (uint8_t newer = index + 1; newer < mAmount; newer++) {
+        age += getEntry(newer).deviceAndTimeDelta & MAX_TIME_DELTA;
+    }
+    return age > MAX_COUNT ? MAX_COUNT : age;
+}
+
+bool History::sendEntry(uint8_t index)
+{
+    const Entry& entry = getEntry(index);
+    device_t deviceNo = entry.deviceAndTimeDelta >> DEVICE_SHIFT;
+    if (!mAgeSent) {
+        Device::getIOHandler()->sendToServer(deviceNo, HISTORY_AGE_NOTIFICATION, getAge(index));
+    } else {
+        Device::getIOHandler()->sendToServer(deviceNo, entry.key, entry.value);
+    }
+    mAgeSent = !mAgeSent;
+    return !mAgeSent;
+}
+
+uint8_t History::findQueryEntry(uint8_t index) const
+{
+    for (; index < mAmount; index++) {
+        if (getEntry(index).key == mQueryKey) {
+            return index;
+        }
+    }
+    return NO_QUERY;
+}
@@ -0,0 +1,126 @@
+/**
+ * ---------------------------------------------------------------------------------------------------
+ * This software is licensed under the GNU LESSER GENERAL PUBLIC LICENSE Version 3. It is furnished
+ * "as is", without any support, and with no warranty, express or implied, as to its usefulness for
+ * any purpose.
+ *
+ * File:      History.h
+ * Purpose:   Store and forward of sensor changes during bus outages. While the IO handler is not
+ *            connected (see SerialIO::isConnected), every change of a State is stored in a ring buffer.
+ *            Once the bus is back, the stored changes are replayed to the server, oldest first, one
+ *            message per schedule loop while the device may send. Every change is sent as a
+ *            HISTORY_AGE_NOTIFICATION ('%') with the age of the change in seconds, followed by the
+ *            notification of the change itself with its original device and key. The server must treat
+ *            a notification following '%' as historical value.
+ *            The entries are kept after the replay. The last entries of a key are sent again on request:
+ *            HISTORY_KEY ('&') to device 0 with the key in the low byte and the amount of entries in the
+ *            high byte (0 = all), example for the last 5 temperatures: {"R": 20, "K": "&", "V": 1396}
+ *            An entry takes 5 bytes: key, device number (3 bits) and the time since the previous entry
+ *            in seconds (13 bits, saturates at 8191 s), value. If the buffer is full, the oldest entry is
+ *            overwritten, even if it is not yet replayed.
+ *
+ * Author:    Volker Böhm
+ * Copyright: Volker Böhm
+ * Version:   1.0
+ * ---------------------------------------------------------------------------------------------------
+ */
+
+#ifndef __HISTORY_H
+#define __HISTORY_H
+
+#include "StdInclude.h"
+
+class History : public NotifyTarget {
+public:
+
+    /**
+     * Amount of entries stored
+     */
+    static const uint8_t SIZE = 24;
+
+    /**
+     * Creates the history handler. It belongs to device 0
+     */
+    History();
+
+    /**
+     * Stores a change, if the IO handler is not connected
+     * @param deviceNo number of the device of the change
+     * @param key key of the change
+     * @param value new value
+     */
+    static void record(device_t deviceNo, key_t key, value_t value);
+
+    /**
+     * Reacts on HISTORY_KEY and starts sending the last entries of a key
+     * @param senderAddress address of the sender
+     * @param key key/identifier of the change
+     * @param data key in the low byte, amount of entries in the high byte
+     */
+    virtual void handleChange(address_t senderAddress, key_t key, StateValue data);
+
+    /**
+     * Sends the next message of the replay or of a query, if the device may send
+     * @param scheduleLoops number of checkState loops since reboot
+     */
+    virtual void checkState(time_t scheduleLoops);
+
+    /**
+     * Gets the amount of entries overwritten before they were replayed
+     * @return amount of entries (saturates at 65535)
+     */
+    static uint16_t getLost() { return mLost; }
+
+private:
+
+    static const uint8_t  DEVICE_SHIFT   = 13;
+    static const uint16_t MAX_TIME_DELTA = (1 << DEVICE_SHIFT) - 1;
+    static const uint8_t  NO_QUERY       = 0xFF;
+    static const uint16_t MAX_COUNT      = 0xFFFF;
+
+    struct Entry {
+        key_t    key;
+        uint16_t deviceAndTimeDelta;
+        value_t  value;
+    };
+
+    /**
+     * Gets an entry
+     * @param index index of the entry, 0 = oldest
+     */
+    static const Entry& getEntry(uint8_t index) { return mEntries[(mHead + SIZE - mAmount + index) % SIZE]; }
+
+    /**
+     * Calculates the age of an entry
+     * @param index index of the entry, 0 = oldest
+     * @return age in seconds (saturates at 65535)
+     */
+    static value_t getAge(uint8_t index);
+
+    /**
+     * Sends the next message of an entry, the age or the change
+     * @param index index of the entry, 0 = oldest
+     * @return true, if the change (the last message of the entry) has been sent
+     */
+    bool sendEntry(uint8_t index);
+
+    /**
+     * Finds the index of the next entry of the current query
+     * @param index index to start with, 0 = oldest
+     * @return index of the next entry having the query key, NO_QUERY if none is left
+     */
+    uint8_t findQueryEntry(uint8_t index) const;
+
+    static Entry    mEntries[SIZE];
+    static uint8_t  mHead;
+    static uint8_t  mAmount;
+    static uint8_t  mUnsent;
+    static time_t   mLastTimeInSeconds;
+    static uint16_t mLost;
+
+    bool    mAgeSent;
+    key_t   mQueryKey;
+    uint8_t mQueryIndex;
+};
+
+#endif // __HISTORY_H
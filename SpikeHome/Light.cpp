@@ -21,11 +21,33 @@ Light::Light(device_t deviceNo, pin_t brightnessPin, pin_t lightOutputPin)
     mLightVoltage = 0;
     mOldLightVoltage = 0;
     mLightOutputPin = lightOutputPin;
+    mCalibrationMessage = NO_CALIBRATION_MESSAGE;
     // if system temperature is not measured the system reacts like in warning mode (lights are always fully on)
     mHeatAlarm = HEAT_ALARM_OFF;
-    pinMode(mLightOutputPin, OUTPUT);
+    mFadeChannel = Fade::attach(mLightOutputPin);
+    if (mFadeChannel == Fade::NO_CHANNEL) {
+        pinMode(mLightOutputPin, OUTPUT);
+    }
 
-    NotifyTarget::setCheckMask(NotifyTarget::CHECKSTATE_ALLWAYS);
+    NotifyTarget::setCheckMask(NotifyTarget::CHECKSTATE_NORMAL);
+    NotifyTarget::setPriority(NotifyTarget::PRIORITY_CRITICAL);
+    NotifyTarget::subscribe(LIGHT_ON_NOTIFICATION);
+    NotifyTarget::subscribe(MOVEMENT_NOTIFICATION);
+    NotifyTarget::subscribe(SYS_TEMPERATURE_NOTIFICATION);
+    NotifyTarget::subscribe(FS20_COMMMAND);
+    NotifyTarget::subscribe(ADJUST_LIGHT);
+    NotifyTarget::subscribe(MAXIMUM_BRIGHTNESS_KEY);
+    NotifyTarget::subscribe(TARGET_BRIGHTNESS_KEY);
+    NotifyTarget::subscribe(START_VOLTAGE_KEY);
+    NotifyTarget::subscribe(FULL_ON_VOLTAGE_KEY);
+    NotifyTarget::subscribe(DIMMING_DELAY_KEY);
+    NotifyTarget::subscribe(SET_LIGHT_TIME);
+    NotifyTarget::subscribe(LIGHT_CONTROL_KEY);
+    NotifyTarget::subscribe(PROPORTIONAL_GAIN_KEY);
+    NotifyTarget::subscribe(INTEGRAL_GAIN_KEY);
+    for (uint8_t point = 0; point < CURVE_POINTS - 2; point++) {
+        NotifyTarget::subscribe(LIGHT_CURVE_KEY + point);
+    }
     initConfig();
 }
 
@@ -36,6 +58,13 @@ void Light::initConfig()
     mStartVoltage = addConfigValue(START_VOLTAGE_KEY, 100);
     mFullOnVoltage = addConfigValue(FULL_ON_VOLTAGE_KEY, MAX_VOLTAGE);
     mDimmingDelay = addConfigValue(DIMMING_DELAY_KEY, 20) / MILLISECONDS_PER_LOOP;
+    mControlMode = addConfigValue(LIGHT_CONTROL_KEY, CONTROL_HYSTERESIS);
+    mProportionalGain = addConfigValue(PROPORTIONAL_GAIN_KEY, BrightnessControl::DEFAULT_PROPORTIONAL_GAIN);
+    mIntegralGain = addConfigValue(INTEGRAL_GAIN_KEY, BrightnessControl::DEFAULT_INTEGRAL_GAIN);
+    mControl.setGains(mProportionalGain, mIntegralGain);
+    for (uint8_t point = 0; point < CURVE_POINTS - 2; point++) {
+        mCurveVoltage[point] = addConfigValue(LIGHT_CURVE_KEY + point, 0);
+    }
 }
 
 void Light::setTargetBrightness(value_t brightnessInPercent)
@@ -46,8 +75,7 @@ void Light::setTargetBrightness(value_t brightnessInPercent)
         setConfigValue(TARGET_BRIGHTNESS_KEY, mTargetBrightness);
         mMaxLightVoltage = 0;
         mOldLightVoltage = 0;
-
-        dimLight();
+        checkAgainIn(0);
     }
 }
 
@@ -67,6 +95,43 @@ void Light::setFullOnVoltage(value_t fullOnVoltage)
     }
 }
 
+void Light::setCurveVoltage(uint8_t point, value_t voltage)
+{
+    if (point < CURVE_POINTS - 2 && voltage <= MAX_VOLTAGE) {
+        mCurveVoltage[point] = voltage;
+        setConfigValue(LIGHT_CURVE_KEY + point, voltage);
+    }
+}
+
+int16_t Light::getCurveVoltage(uint8_t point)
+{
+    if (point == 0) {
+        return mStartVoltage;
+    }
+    if (point >= CURVE_POINTS - 1) {
+        return mFullOnVoltage;
+    }
+    if (mCurveVoltage[point - 1] != 0) {
+        return mCurveVoltage[point - 1];
+    }
+    return mStartVoltage + (int16_t(mFullOnVoltage) - int16_t(mStartVoltage)) * point / (CURVE_POINTS - 1);
+}
+
+int16_t Light::calcCurveVoltage(value_t brightnessInPercent)
+{
+    int16_t voltage;
+    if (brightnessInPercent >= 100) {
+        voltage = int32_t(int16_t(mFullOnVoltage) - int16_t(mStartVoltage)) * brightnessInPercent / 100;
+    } else {
+        uint8_t point = brightnessInPercent / CURVE_STEP_IN_PERCENT;
+        int16_t low = getCurveVoltage(point);
+        int16_t high = getCurveVoltage(point + 1);
+        voltage = low + (high - low) * int16_t(brightnessInPercent % CURVE_STEP_IN_PERCENT) / CURVE_STEP_IN_PERCENT;
+        voltage -= mStartVoltage;
+    }
+    return voltage > 0 ? voltage : 0;
+}
+
 void Light::setDimmingDelay(value_t dimmingDelayInMilliseconds)
 {
     if (dimmingDelayInMilliseconds >= 10 && dimmingDelayInMilliseconds <= 999) {
@@ -76,6 +141,28 @@ void Light::setDimmingDelay(value_t dimmingDelayInMilliseconds)
 
 }
 
+void Light::setControlMode(value_t controlMode)
+{
+    if (controlMode == CONTROL_HYSTERESIS || controlMode == CONTROL_PI) {
+        mControlMode = controlMode;
+        setConfigValue(LIGHT_CONTROL_KEY, mControlMode);
+        mControl.reset(mLightVoltage);
+    }
+}
+
+void Light::setGain(key_t key, value_t gain)
+{
+    if (gain <= 16 * BrightnessControl::GAIN_ONE) {
+        if (key == PROPORTIONAL_GAIN_KEY) {
+            mProportionalGain = gain;
+        } else {
+            mIntegralGain = gain;
+        }
+        setConfigValue(key, gain);
+        mControl.setGains(mProportionalGain, mIntegralGain);
+    }
+}
+
 void Light::setMaximumBrightness(value_t brightnessInPercent)
 {
     if (brightnessInPercent >= 10 && brightnessInPercent <= 200) {
@@ -92,9 +179,9 @@ void Light::handleFS20Command(value_t value)
     printVariableIfDebug(command);
     printVariableIfDebug(suffix);
     if (suffix == 1 && command == 0x11) {
-        mState.setAdjustLight();
+        startAdjustProgram();
     } else if (command <= 0x10 && command > 0) {
-        setTargetBrightness(floor(command * 6.25));
+        setTargetBrightness(command * 25 / 4);
     } else if (command == 0x13) {
         setTargetBrightness(min(120, mTargetBrightness + 6));
     } else if (command == 0x14) {
@@ -104,9 +191,9 @@ void Light::handleFS20Command(value_t value)
 
 void Light::handleSystemTemperature(StateValue value)
 {
-    float heat = value.toFloat();
+    int32_t heat = value.toSigned();
     if (mHeatAlarm == HEAT_ALARM_CRITICAL) {
-        heat *= HEAT_HYSTERESE;
+        heat = heat * HEAT_HYSTERESIS_IN_PERCENT / 100;
     }
     mHeatAlarm = HEAT_ALARM_OFF;
     if (heat > HEAT_CRITICAL_VALUE) {
@@ -142,7 +229,7 @@ void Light::handleChange(address_t senderAddress, key_t key, StateValue data)
             break;
         case FS20_COMMMAND: handleFS20Command(value);
             break;
-        case ADJUST_LIGHT: mState.setAdjustLight();
+        case ADJUST_LIGHT: startAdjustProgram();
             break;
         case MAXIMUM_BRIGHTNESS_KEY: setMaximumBrightness(value);
             break;
@@ -154,6 +241,17 @@ void Light::handleChange(address_t senderAddress, key_t key, StateValue data)
             break;
         case DIMMING_DELAY_KEY: setDimmingDelay(value);
             break;
+        case LIGHT_CONTROL_KEY: setControlMode(value);
+            break;
+        case PROPORTIONAL_GAIN_KEY:
+        case INTEGRAL_GAIN_KEY:
+            setGain(key, value);
+            break;
+        case LIGHT_CURVE_KEY:
+        case LIGHT_CURVE_KEY + 1:
+        case LIGHT_CURVE_KEY + 2:
+            setCurveVoltage(key - LIGHT_CURVE_KEY, value);
+            break;
         case SET_LIGHT_TIME:
             if (value != 0) {
                 mState.setLight(true, true);
@@ -164,6 +262,8 @@ void Light::handleChange(address_t senderAddress, key_t key, StateValue data)
             break;
 
     }
+    // The light is checked seldom while it is not dimming, react in the next loop
+    checkAgainIn(0);
 }
 
 bool Light::dimLight()
@@ -173,7 +273,9 @@ bool Light::dimLight()
     static const int16_t STEP_DIFF = 20;
     static const int16_t HYSTERESE = 5;
 
-    if (mState.isUsingLight()) {
+    if (isControlling()) {
+        return controlBrightness();
+    } else if (mState.isUsingLight()) {
         int16_t curBrightness = int16_t(getAbsoluteValue());
         int16_t targetBrightness = calcAbsoluteTarget(mTargetBrightness);
         if (mHeatAlarm == HEAT_ALARM_WARNING) {
@@ -184,15 +286,39 @@ bool Light::dimLight()
             targetBrightness = 0;
         }
 
-        voltageDiff = mState.dimmingStep(curBrightness, targetBrightness);
+        voltageDiff = mState.dimmingStep(curBrightness, targetBrightness) * DIMMING_STEP;
     } else if (mLightVoltage > 0) {
-        voltageDiff = -1;
+        voltageDiff = -mLightVoltage;
     }
 
     bool isDimming = changeLightVoltage(voltageDiff);
     return isDimming;
 }
 
+bool Light::controlBrightness()
+{
+    int16_t maxVoltage = mFullOnVoltage > mStartVoltage ? mFullOnVoltage - mStartVoltage : 1;
+    int16_t newVoltage;
+    int16_t measured = getValue().toInt();
+
+    if (mLightVoltage == 0) {
+        // Starts at the voltage of the light curve adding the missing brightness
+        mControl.reset(calcCurveVoltage(mTargetBrightness > measured ? mTargetBrightness - measured : 0));
+    }
+    if (mHeatAlarm == HEAT_ALARM_WARNING) {
+        // Switch the lamp fully on to reduce heat
+        newVoltage = MAX_VOLTAGE - mStartVoltage;
+        mControl.reset(maxVoltage);
+    } else if (mHeatAlarm == HEAT_ALARM_CRITICAL) {
+        newVoltage = 1;
+        mControl.reset(newVoltage);
+    } else {
+        newVoltage = mControl.step(mTargetBrightness, measured, 1, maxVoltage);
+    }
+    // The fade to the new voltage takes one control period
+    return setLightVoltage(newVoltage, mDimmingDelay * MILLISECONDS_PER_LOOP);
+}
+
 int16_t Light::calcNextVoltage(int16_t curVoltage, bool higher)
 {
     int16_t result;
@@ -212,69 +338,109 @@ int16_t Light::calcNextVoltage(int16_t curVoltage, bool higher)
     return result;
 }
 
+void Light::startAdjustProgram()
+{
+    mState.setAdjustLight();
+    mAdjustTask.restart();
+    mLightVoltage = MAX_VOLTAGE;
+    mCalibrationStep = 0;
+    mCurvePoint = 0;
+    reportCalibration(0);
+}
+
+bool Light::runAdjustProgram()
+{
+    TASK_BEGIN(mAdjustTask);
+    while (mState.isAdjustProgramRunning()) {
+        setLightVoltageToOutputPin(mLightVoltage, 0);
+        mSettle.start(MAX_SETTLE_WINDOWS);
+        TASK_WAIT_UNTIL(mAdjustTask, mSettle.add(getAbsoluteValue()));
+        mLightVoltage = adjustLight(mLightVoltage, mSettle.getMean());
+    }
+    mLightVoltage = 0;
+    setLightVoltageToOutputPin(0, 0);
+    TASK_END(mAdjustTask);
+}
+
+void Light::reportCalibration(value_t progressInPercent)
+{
+    mCalibrationProgress = progressInPercent;
+    mCalibrationMessage = 0;
+    // The finished calibration sends the light curve after the progress
+    mCalibrationMessages = progressInPercent == 100 ? 1 + CURVE_POINTS : 1;
+    requestReport();
+}
+
 int16_t Light::adjustLight(int16_t curVoltage, int16_t curBrightness)
 {
-    int16_t result = 0;
+    int16_t result = curVoltage;
     switch (mState.getState()) {
         case LightState::LIGHT_MEASURE_MAX_BRIGHTNESS:
-            result = 255;
-            if (mState.isBrightnessReliable()) {
-                setFullOnBrightness(curBrightness);
-                mState.nextAdjustLightState();
-                result = 128;
+            if (curBrightness <= MAX_ANALOG_READ_VALUE / 8) {
+                // The lamp does not shine or the sensor does not see it, keep the current calibration
+                mState.stopAdjustLight();
+                reportCalibration(CALIBRATION_FAILED);
+                return curVoltage;
             }
+            setFullOnBrightness(curBrightness);
+            mState.nextAdjustLightState();
+            result = FIRST_SEARCH_VOLTAGE;
             break;
         case LightState::LIGHT_MEASURE_MIN_VOLTAGE:
-            result = curVoltage;
-            if (mState.isBrightnessReliable()) {
-                result = calcNextVoltage(curVoltage, curBrightness < 3);
-                if (result == curVoltage) {
-                    setStartVoltage(curVoltage);
-                    mState.nextAdjustLightState();
-                    result = 128;
-                }
+            result = calcNextVoltage(curVoltage, curBrightness < START_BRIGHTNESS_THRESHOLD);
+            if (result == curVoltage) {
+                setStartVoltage(curVoltage);
+                mState.nextAdjustLightState();
+                result = FIRST_SEARCH_VOLTAGE;
             }
             break;
         case LightState::LIGHT_MEASURE_MAX_VOLTAGE:
-            result = curVoltage;
-            if (mState.isBrightnessReliable()) {
-                result = calcNextVoltage(curVoltage, curBrightness < mFullOnBrightness);
-                if (result == curVoltage) {
-                    setFullOnVoltage(curVoltage);
+            result = calcNextVoltage(curVoltage, curBrightness < int16_t(mFullOnBrightness));
+            if (result == curVoltage) {
+                setFullOnVoltage(curVoltage);
+                mState.nextAdjustLightState();
+                result = FIRST_SEARCH_VOLTAGE;
+            }
+            break;
+        case LightState::LIGHT_MEASURE_CURVE:
+            result = calcNextVoltage(curVoltage,
+                curBrightness < int16_t(calcAbsoluteTarget((mCurvePoint + 1) * CURVE_STEP_IN_PERCENT)));
+            if (result == curVoltage) {
+                setCurveVoltage(mCurvePoint, curVoltage);
+                mCurvePoint++;
+                if (mCurvePoint >= CURVE_POINTS - 2) {
                     mState.nextAdjustLightState();
-                    result = 128;
                 }
+                result = FIRST_SEARCH_VOLTAGE;
             }
             break;
     }
 
-    if (result != 0) {
-        if (mState.isBrightnessReliable()) {
-            Serial.println(mState.getState());
-            Serial.println(curVoltage);
-            Serial.println(curBrightness);
-            Serial.println(result);
-        }
-        mState.waitForReliableBrightness();
+    mCalibrationStep++;
+    if (mState.isAdjustProgramRunning()) {
+        reportCalibration(value_t(mCalibrationStep) * 100 / CALIBRATION_STEPS);
+    } else {
+        reportCalibration(100);
     }
     return result;
 }
 
 void Light::checkState(time_t scheduleLoops)
 {
-    bool isDimming = false;
-
-    if (scheduleLoops % mDimmingDelay == 0) {
-        if (mState.isAdjustProgramRunning()) {
-            mLightVoltage = adjustLight(mLightVoltage, getAbsoluteValue());
-            this->setLightVoltageToOutputPin(mLightVoltage);
-        } else {
-            isDimming = dimLight();
-        }
-    }
-    if ((scheduleLoops & NotifyTarget::CHECKSTATE_SELDOM) == 0 && !isDimming) {
+    if (mState.isAdjustProgramRunning()) {
+        runAdjustProgram();
+        // The adjust program samples the brightness every loop
+        checkAgainIn(1);
+    } else if (dimLight()) {
+        // The fade engine runs the step, check again when it is done
+        checkAgainIn(isControlling() ? mDimmingDelay : mDimmingDelay * DIMMING_STEP);
+    } else {
         mState.checkForDarkness(isDarkEnoughToSwitchOnLight());
         State::checkState(scheduleLoops);
+        if (isControlling()) {
+            // The PI controller needs a constant control period
+            checkAgainIn(mDimmingDelay);
+        }
     }
 }
 
@@ -286,6 +452,29 @@ bool Light::notifyServer(StateValue value)
     return result;
 }
 
+bool Light::sendReport()
+{
+    if (mCalibrationMessage == NO_CALIBRATION_MESSAGE) {
+        return BrightnessSensor::sendReport();
+    }
+    bool sent;
+    if (mCalibrationMessage == 0) {
+        sent = sendToServer(LIGHT_CALIBRATION_NOTIFICATION, StateValue(mCalibrationProgress));
+    } else {
+        uint8_t point = mCalibrationMessage - 1;
+        value_t brightnessInPercent = point * CURVE_STEP_IN_PERCENT;
+        sent = sendToServer(LIGHT_CURVE_NOTIFICATION, StateValue(value_t((getCurveVoltage(point) << 8) | brightnessInPercent)));
+    }
+    if (sent) {
+        mCalibrationMessage++;
+        if (mCalibrationMessage >= mCalibrationMessages) {
+            mCalibrationMessage = NO_CALIBRATION_MESSAGE;
+        }
+    }
+    // The report stays queued until the last message is sent, one message per schedule loop
+    return mCalibrationMessage == NO_CALIBRATION_MESSAGE;
+}
+
 bool Light::hasMaxVoltage()
 {
     return mLightVoltage >= (int16_t)(MAX_VOLTAGE - mStartVoltage);
@@ -297,7 +486,7 @@ int16_t Light::calcNewVoltage(int16_t voltageDiff)
     bool lightIsOnButMaxDimmed;
 
     if (voltageDiff != 0) {
-        int16_t targetVoltage = ((mFullOnVoltage - mStartVoltage) * (mTargetBrightness + 10)) / 100;
+        int16_t targetVoltage = calcCurveVoltage(mTargetBrightness + 10);
 
         if (mLightVoltage + mStartVoltage > mFullOnVoltage) {
             newVoltage = voltageDiff > 0 ? MAX_VOLTAGE : mFullOnVoltage;
@@ -320,6 +509,12 @@ int16_t Light::calcNewVoltage(int16_t voltageDiff)
 bool Light::changeLightVoltage(int16_t voltageDiff)
 {
     int16_t newVoltage = calcNewVoltage(voltageDiff);
+    uint32_t duration = uint32_t(abs(newVoltage - mLightVoltage)) * mDimmingDelay * MILLISECONDS_PER_LOOP;
+    return setLightVoltage(newVoltage, duration);
+}
+
+bool Light::setLightVoltage(int16_t newVoltage, uint32_t durationInMilliseconds)
+{
     bool res = false;
 
     if (newVoltage != mLightVoltage) {
@@ -328,15 +523,19 @@ bool Light::changeLightVoltage(int16_t voltageDiff)
             mMaxLightVoltage = 0;
         }
         mLightVoltage = newVoltage;
-        setLightVoltageToOutputPin(newVoltage == 0 ? 0 : newVoltage + mStartVoltage);
+        setLightVoltageToOutputPin(newVoltage == 0 ? 0 : newVoltage + mStartVoltage, durationInMilliseconds);
         res = true;
     }
     return res;
 }
 
-void Light::setLightVoltageToOutputPin(int16_t newVoltage)
+void Light::setLightVoltageToOutputPin(int16_t newVoltage, uint32_t durationInMilliseconds)
 {
-    analogWrite(mLightOutputPin, newVoltage);
+    if (mFadeChannel == Fade::NO_CHANNEL) {
+        analogWrite(mLightOutputPin, newVoltage);
+    } else {
+        Fade::start(mFadeChannel, newVoltage, durationInMilliseconds > 0xFFFF ? 0xFFFF : durationInMilliseconds);
+    }
     printVariableIfDebug(newVoltage);
 }
 
@@ -19,6 +19,10 @@
 #include "State.h"
 #include "BrightnessSensor.h"
 #include "LightState.h"
+#include "Task.h"
+#include "Fade.h"
+#include "BrightnessControl.h"
+#include "SettleDetector.h"
 
 class Brightness;
 
@@ -57,6 +61,12 @@ public:
      */
     virtual bool notifyServer(StateValue value);
 
+    /**
+     * Sends the progress and the result of the calibration, one message per call, or the brightness
+     * @return true, if all pending messages are sent
+     */
+    virtual bool sendReport();
+
 
     /**
      * Sets the target brightness in percent of the maximal achievable brightness
@@ -79,16 +89,55 @@ private:
     void handleFS20Command(value_t command);
 
     /**
-     * Dims the light up or down until it reached a brightness target
+     * Dims the light up or down until it reached a brightness target. Every call issues one fade of
+     * DIMMING_STEP levels, switching off issues a single fade to 0.
      * @retun true, if currently dimming up or down. Fals if light is not changing
      */
     bool dimLight();
 
     /**
-     * Adjusts light settings
-     * @param curVoltage voltage to set to output pin to follow the adjust voltage program
-     * @param curBrightness current brightness sensor value
-     * @return new light voltage or 0 if adjust program is not running
+     * Sets the light level calculated by the PI controller
+     * @return true, if the light level has been changed
+     */
+    bool controlBrightness();
+
+    /**
+     * Checks, if the PI controller steers the light
+     */
+    bool isControlling() { return mControlMode == CONTROL_PI && mState.isUsingLight(); }
+
+    /**
+     * Selects the brightness control
+     * @param controlMode CONTROL_HYSTERESIS or CONTROL_PI
+     */
+    void setControlMode(value_t controlMode);
+
+    /**
+     * Sets a gain of the PI controller
+     * @param key PROPORTIONAL_GAIN_KEY or INTEGRAL_GAIN_KEY
+     * @param gain gain in 1/256 level per percent
+     */
+    void setGain(key_t key, value_t gain);
+
+    /**
+     * Starts the adjust program measuring full on brightness, start voltage, full on voltage and the
+     * light curve in between
+     */
+    void startAdjustProgram();
+
+    /**
+     * Runs the adjust program. Every step sets a voltage and samples the brightness every schedule loop
+     * until it is settled (at most MAX_SETTLE_WINDOWS windows) before the next step is calculated.
+     * The progress is reported after every step.
+     * @return true, while the adjust program is running
+     */
+    bool runAdjustProgram();
+
+    /**
+     * Calculates the next step of the adjust program
+     * @param curVoltage voltage currently set to the output pin
+     * @param curBrightness brightness sensor value measured with curVoltage
+     * @return voltage for the next step
      */
     int16_t adjustLight(int16_t curVoltage, int16_t curBrightness);
 
@@ -101,10 +150,38 @@ private:
     int16_t calcNextVoltage(int16_t curVoltage, bool higher);
 
     /**
-     * Sets voltage to the output pin by analogWrite
-     * @param voltage new voltage for the PWM pin
+     * Stores a point of the light curve
+     * @param point 0 .. CURVE_POINTS - 3, the point at (point + 1) * CURVE_STEP_IN_PERCENT
+     * @param voltage light level reaching the brightness of the point
+     */
+    void setCurveVoltage(uint8_t point, value_t voltage);
+
+    /**
+     * Gets the light level of a point of the light curve, not measured points are interpolated
+     * @param point 0 (start voltage) .. CURVE_POINTS - 1 (full on voltage)
+     * @return light level 0 .. 255
+     */
+    int16_t getCurveVoltage(uint8_t point);
+
+    /**
+     * Calculates the voltage reaching a brightness by the light curve, above 100% the voltage is
+     * extrapolated linearly
+     * @param brightnessInPercent brightness in percent of the full on brightness
+     * @return voltage above the start voltage
+     */
+    int16_t calcCurveVoltage(value_t brightnessInPercent);
+
+    /**
+     * Requests to send the calibration progress to the server
+     * @param progressInPercent progress, 100 = finished, CALIBRATION_FAILED = no light measured
+     */
+    void reportCalibration(value_t progressInPercent);
+    /**
+     * Fades the output pin to a new voltage (see Fade)
+     * @param voltage new level of the PWM pin 0 .. 255, gamma corrected
+     * @param durationInMilliseconds duration of the fade, 0 = immediately
      */
-    void setLightVoltageToOutputPin(int16_t voltage);
+    void setLightVoltageToOutputPin(int16_t voltage, uint32_t durationInMilliseconds);
 
     /**
      * Calculates the new voltage for the PWM pin
@@ -120,6 +197,14 @@ private:
      */
     bool changeLightVoltage(int16_t voltageDiff);
 
+    /**
+     * Fades the light voltage of the output pin to a new value
+     * @param newVoltage new voltage above the start voltage, 0 = off
+     * @param durationInMilliseconds duration of the fade
+     * @return true, if light voltage has been changed
+     */
+    bool setLightVoltage(int16_t newVoltage, uint32_t durationInMilliseconds);
+
     /**
      * Checks current system temperature and adjust lights if it gets too hot
      * @param value current system temperature of the light steering transistor
@@ -133,7 +218,7 @@ private:
 
     /**
      * Sets a new startVoltage
-     * @param startVoltage voltage in pwm units from 0..255
+     * @param startVoltage level of the fade engine from 0..255
      */
     void setStartVoltage(value_t startVoltage);
 
@@ -145,7 +230,7 @@ private:
 
     /**
      * Sets the minimal voltage where lights are 100% on
-     * @param fullOnVoltage voltage in pwm units from 0..255
+     * @param fullOnVoltage level of the fade engine from 0..255
      */
     void setFullOnVoltage(value_t fullOnVoltage);
 
@@ -156,27 +241,69 @@ private:
     void setMaximumBrightness(value_t brightnessInPercent);
 
     static const time_t TICKS_IN_MS_UNTIL_NEXT_INFO = 1000L * 60L * 10L;
-    static const int16_t MAX_VOLTAGE = 255;
+    static const int16_t MAX_VOLTAGE = Fade::MAX_LEVEL;
+    /**
+     * Levels changed by one dimming step, the fade of a step takes DIMMING_STEP * dimming delay
+     */
+    static const int16_t DIMMING_STEP = 4;
     static const uint16_t DELAY_IN_MILLISECONDS_BETWEEN_BRIGHTNESS_MEASURES = 1000;
 
+    /**
+     * Calibration: every voltage is measured until the brightness is settled, at most
+     * MAX_SETTLE_WINDOWS * SettleDetector::WINDOW_SAMPLES schedule loops (480 ms). The calibration
+     * measures the full on brightness and runs binary searches of SEARCH_STEPS for the start voltage,
+     * the full on voltage and the curve points in between, it takes at most CALIBRATION_STEPS * 480 ms.
+     */
+    static const uint8_t MAX_SETTLE_WINDOWS = 6;
+    static const uint8_t SEARCH_STEPS = 8;
+    static const int16_t FIRST_SEARCH_VOLTAGE = 128;
+    static const int16_t START_BRIGHTNESS_THRESHOLD = 3;
+    static const uint8_t CURVE_STEP_IN_PERCENT = 25;
+    static const uint8_t CURVE_POINTS = 100 / CURVE_STEP_IN_PERCENT + 1;
+    static const uint8_t CALIBRATION_STEPS = 1 + SEARCH_STEPS * CURVE_POINTS;
+    static const value_t CALIBRATION_FAILED = 0xFFFF;
+    static const uint8_t NO_CALIBRATION_MESSAGE = 0xFF;
+
+    /**
+     * Brightness control: hysteresis steps of LightState or PI controller
+     */
+    static const value_t CONTROL_HYSTERESIS = 0;
+    static const value_t CONTROL_PI = 1;
+
     static const uint16_t HEAT_ALARM_OFF = 0;
     static const uint16_t HEAT_ALARM_WARNING = 1;
     static const uint16_t HEAT_ALARM_CRITICAL = 2;
-    static constexpr float HEAT_HYSTERESE = 1.1;
-    static constexpr float HEAT_WARNING_VALUE = 70;
-    static constexpr float HEAT_CRITICAL_VALUE = 80;
+    /**
+     * System temperatures in 1/100 degree celsius, a critical temperature is increased by the hysteresis
+     */
+    static const int16_t HEAT_HYSTERESIS_IN_PERCENT = 110;
+    static const int16_t HEAT_WARNING_VALUE = 7000;
+    static const int16_t HEAT_CRITICAL_VALUE = 8000;
 
     pin_t mLightOutputPin;
+    uint8_t mFadeChannel;
     uint16_t mHeatAlarm;
 
     LightState mState;
     int16_t mLightVoltage;
     int16_t mOldLightVoltage;
     int16_t mMaxLightVoltage;
+    Task mAdjustTask;
+    SettleDetector mSettle;
+    BrightnessControl mControl;
 
     value_t mMaximumBrightness;
     value_t mTargetBrightness;
     value_t mStartVoltage;
     value_t mFullOnVoltage;
     value_t mDimmingDelay;
+    value_t mControlMode;
+    value_t mProportionalGain;
+    value_t mIntegralGain;
+    value_t mCurveVoltage[CURVE_POINTS - 2];
+    uint8_t mCurvePoint;
+    uint8_t mCalibrationStep;
+    value_t mCalibrationProgress;
+    uint8_t mCalibrationMessage;
+    uint8_t mCalibrationMessages;
 };
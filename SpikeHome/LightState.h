@@ -29,6 +29,7 @@ public:
     static const uint8_t LIGHT_MEASURE_MAX_BRIGHTNESS   = 16;
     static const uint8_t LIGHT_MEASURE_MIN_VOLTAGE      = 17;
     static const uint8_t LIGHT_MEASURE_MAX_VOLTAGE      = 18;
+    static const uint8_t LIGHT_MEASURE_CURVE            = 19;
 
     static const int16_t DIM_UP                          = 1;
     static const int16_t DIM_STOP                        = 0;
@@ -62,6 +63,16 @@ public:
         wait = 0;
     }
 
+    /**
+     * Stops the light adjustments
+     */
+    void stopAdjustLight()
+    {
+        if (isAdjustProgramRunning()) {
+            mState = LIGHT_OFF;
+        }
+    }
+
     /**
      * Adjusts the state by darkness information
      * @param darkEnoughToSwithOnLight true, if it is dark enought to switch on the lights.
@@ -137,7 +148,7 @@ public:
      */
     bool isAdjustProgramRunning()
     {
-        return (mState >= LIGHT_MEASURE_MAX_BRIGHTNESS && mState <= LIGHT_MEASURE_MAX_VOLTAGE);
+        return (mState >= LIGHT_MEASURE_MAX_BRIGHTNESS && mState <= LIGHT_MEASURE_CURVE);
     }
 
     /**
@@ -145,25 +156,13 @@ public:
      */
     void nextAdjustLightState()
     {
-        if (mState >= LIGHT_MEASURE_MAX_BRIGHTNESS && mState < LIGHT_MEASURE_MAX_VOLTAGE) {
+        if (mState >= LIGHT_MEASURE_MAX_BRIGHTNESS && mState < LIGHT_MEASURE_CURVE) {
             mState++;
-        } else if (mState == LIGHT_MEASURE_MAX_VOLTAGE) {
+        } else if (mState == LIGHT_MEASURE_CURVE) {
             mState = LIGHT_OFF;
         }
     }
 
-    /**
-     * Increases an internal wait counter until the current brightness measurement is reliable.
-     */
-    void waitForReliableBrightness()
-    {
-        if (isBrightnessReliable()) {
-            wait = 0;
-        } else {
-            wait ++;
-        }
-    }
-
     /**
      * Checks if lights are switched on
      * @return true, if lights are switched on
@@ -176,12 +175,6 @@ public:
      */
     bool isUsingLight() { return isOn() && mState != LIGHT_ON_BRIGHT; }
 
-    /**
-     * Checks if lights are long enough in the same state to safely measure brightness
-     * @return true, if brightness is reliable
-     */
-    bool isBrightnessReliable() { return wait >= WAIT_FOR_RELIABLE_BRIGHTNESS_MEASUREMENT; }
-
     /**
      * Gets the current state
      * @return state
@@ -244,7 +237,6 @@ private:
     static const int16_t LARGE_BRIGHTNESS_DIFFERENCE = 30;
     static const int16_t SMALL_BRIGHTNESS_DIFFERENCE = 12;
     static const uint8_t MAX_WAIT = 20;
-    static const uint8_t WAIT_FOR_RELIABLE_BRIGHTNESS_MEASUREMENT = 100;
 
 
 };
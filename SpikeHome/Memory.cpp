@@ -0,0 +1,102 @@
+/**
+ * ---------------------------------------------------------------------------------------------------
+ * This software is licensed under the GNU LESSER GENERAL PUBLIC LICENSE Version 3. It is furnished
+ * "as is", without any support, and with no warranty, express or implied, as to its usefulness for
+ * any purpose.
+ *
+ * File:      Memory.cpp
+ *
+ * Author:    Volker Böhm
+ * Copyright: Volker Böhm
+ * Version:   1.0
+ * ---------------------------------------------------------------------------------------------------
+ */
+
+#include "Memory.h"
+
+/**
+ * Memory layout symbols provided by the linker and by the avr-libc malloc implementation
+ */
+extern uint8_t _end;
+extern uint8_t __stack;
+extern int __heap_start, *__brkval;
+extern int __data_start, __bss_end;
+
+struct __freelist {
+    size_t sz;
+    struct __freelist* nx;
+};
+extern struct __freelist* __flp;
+
+/**
+ * Fills the RAM between the end of the static data and the stack with the canary value. It is placed in
+ * the .init1 section thus it runs before the C runtime sets up registers and stack. Due to this it must
+ * be written in assembler.
+ */
+void paintStack() __attribute__ ((naked)) __attribute__ ((section (".init1")));
+
+void paintStack()
+{
+    __asm volatile (
+        "    ldi r30, lo8(_end)   \n"
+        "    ldi r31, hi8(_end)   \n"
+        "    ldi r24, 0xC5        \n"   // STACK_CANARY
+        "    ldi r25, hi8(__stack)\n"
+        "    rjmp .cmp            \n"
+        ".loop:                   \n"
+        "    st Z+, r24           \n"
+        ".cmp:                    \n"
+        "    cpi r30, lo8(__stack)\n"
+        "    cpc r31, r25         \n"
+        "    brlo .loop           \n"
+        "    breq .loop           \n"
+        ::);
+}
+
+uint16_t Memory::getUnusedStack()
+{
+    const uint8_t* pos = __brkval == 0 ? (uint8_t*) &__heap_start : (uint8_t*) __brkval;
+    uint16_t count = 0;
+    while (pos <= &__stack && *pos == STACK_CANARY) {
+        pos++;
+        count++;
+    }
+    return count;
+}
+
+uint16_t Memory::getHeapSize()
+{
+    return __brkval == 0 ? 0 : (int) __brkval - (int) &__heap_start;
+}
+
+uint16_t Memory::getFreeListSize()
+{
+    uint16_t size = 0;
+    for (struct __freelist* current = __flp; current != 0; current = current->nx) {
+        size += current->sz + sizeof(size_t);
+    }
+    return size;
+}
+
+uint16_t Memory::getLargestFreeBlock()
+{
+    uint16_t largest = 0;
+    for (struct __freelist* current = __flp; current != 0; current = current->nx) {
+        largest = max(largest, uint16_t(current->sz));
+    }
+    return largest;
+}
+
+uint16_t Memory::getFreeListBlocks()
+{
+    uint16_t blocks = 0;
+    for (struct __freelist* current = __flp; current != 0; current = current->nx) {
+        blocks++;
+    }
+    return blocks;
+}
+
+uint16_t Memory::getStaticDataSize()
+{
+    return (int) &__bss_end - (int) &__data_start;
+}
@@ -0,0 +1,79 @@
+/**
+ * ---------------------------------------------------------------------------------------------------
+ * This software is licensed under the GNU LESSER GENERAL PUBLIC LICENSE Version 3. It is furnished
+ * "as is", without any support, and with no warranty, express or implied, as to its usefulness for
+ * any purpose.
+ *
+ * File:      Memory.h
+ * Purpose:   Memory instrumentation. Trace::getFreeMemory() only shows the current gap between heap
+ *            and stack. This class adds
+ *            - stack painting: the free RAM is filled with a canary byte before main() is called.
+ *              Bytes still holding the canary have never been touched by the stack (high-water mark)
+ *            - heap free list analysis to detect fragmentation (holes in the heap)
+ *            - the size of the static data (.data + .bss)
+ *            Pure static class
+ *
+ * Author:    Volker Böhm
+ * Copyright: Volker Böhm
+ * Version:   1.0
+ * ---------------------------------------------------------------------------------------------------
+ */
+
+#ifndef __MEMORY_H
+#define __MEMORY_H
+
+#include "StdInclude.h"
+
+class Memory {
+public:
+
+    /**
+     * Value written to the free RAM on startup
+     */
+    static const uint8_t STACK_CANARY = 0xC5;
+
+    /**
+     * Counts the bytes between heap and stack never touched by the stack since reboot. This is the
+     * amount of memory left in the worst case seen so far (stack high-water mark).
+     * @return amount of bytes never used by the stack
+     */
+    static uint16_t getUnusedStack();
+
+    /**
+     * Gets the amount of memory allocated for the heap including holes
+     * @return heap size in bytes
+     */
+    static uint16_t getHeapSize();
+
+    /**
+     * Sums up the memory in the heap free list (holes in the heap, not usable for the stack)
+     * @return amount of bytes in the free list
+     */
+    static uint16_t getFreeListSize();
+
+    /**
+     * Gets the size of the largest block in the heap free list
+     * @return size of the largest free block in bytes
+     */
+    static uint16_t getLargestFreeBlock();
+
+    /**
+     * Gets the amount of blocks in the heap free list. More than one block shows a fragmented heap
+     * @return amount of free blocks
+     */
+    static uint16_t getFreeListBlocks();
+
+    /**
+     * Gets the size of the statically allocated memory (global and static variables)
+     * @return size of .data and .bss section in bytes
+     */
+    static uint16_t getStaticDataSize();
+
+private:
+    /**
+     * Pure static class
+     */
+    Memory();
+};
+
+#endif // __MEMORY_H
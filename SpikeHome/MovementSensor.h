@@ -33,6 +33,8 @@ public:
         pinMode(mPin, INPUT);
         mMoveDetected = false;
         NotifyTarget::setCheckMask(NotifyTarget::CHECKSTATE_NORMAL);
+        NotifyTarget::setPriority(NotifyTarget::PRIORITY_CRITICAL);
+        captureEdges(mPin);
     }
 
 protected:
@@ -44,7 +46,7 @@ protected:
     virtual StateValue getValue()
     {
         uint8_t result = 0;
-        if (digitalReadState(mPin, false) == HIGH)
+        if (readState(mPin, false) == HIGH)
         {
             result = mActiveValue;
             mMoveDetected = true;
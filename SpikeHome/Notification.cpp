@@ -83,19 +83,7 @@ void Notification::printToSerial(HardwareSerial* serial) const
     serial->print(F(") "));
     serial->print((char) mKey);
     serial->print(F(" = "));
-    switch (mKey) {
-        case 't':
-        case 'h':
-        case 's':
-            serial->print(mValue.toFloat());
-            break;
-        case 'p':
-            serial->print(mValue.toInt() * 2L);
-            break;
-        default:
-            serial->print(mValue.toInt());
-            break;
-    }
+    mValue.print(*serial, mKey);
     serial->println();
 }
 
@@ -110,19 +98,7 @@ void Notification::printJsonToSerial(HardwareSerial* serial) const
     serial->print(F(", \"K\": \""));
     serial->print((char) mKey);
     serial->print(F("\", \"V\": "));
-    switch (mKey) {
-        case 't':
-        case 'h':
-        case 's':
-            serial->print(mValue.toFloat());
-            break;
-        case 'p':
-            serial->print(mValue.toInt() * 2L);
-            break;
-        default:
-            serial->print(mValue.toInt());
-            break;
-    }
+    mValue.print(*serial, mKey);
     serial->println(F("}"));
 }
 
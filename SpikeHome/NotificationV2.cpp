@@ -151,19 +151,7 @@ void NotificationV2::printToSerial(HardwareSerial* serial) const
     serial->print(F(") "));
     serial->print((char) mKey);
     serial->print(F(" = "));
-    switch (mKey) {
-        case 't':
-        case 'h':
-        case 's':
-            serial->print(mValue.toFloat());
-            break;
-        case 'p':
-            serial->print(mValue.toInt() * 2L);
-            break;
-        default:
-            serial->print(mValue.toInt());
-            break;
-    }
+    mValue.print(*serial, mKey);
     serial->println();
 }
 
@@ -179,19 +167,7 @@ void NotificationV2::printJsonToSerial(HardwareSerial* serial) const
     serial->print(F(", \"K\": \""));
     serial->print((char) mKey);
     serial->print(F("\", \"V\": "));
-    switch (mKey) {
-        case 't':
-        case 'h':
-        case 's':
-            serial->print(mValue.toFloat());
-            break;
-        case 'p':
-            serial->print(mValue.toInt() * 2L);
-            break;
-        default:
-            serial->print(mValue.toInt());
-            break;
-    }
+    mValue.print(*serial, mKey);
     serial->print(F(", \"C\": \"0x"));
     Trace::printHex(uint8_t(crc16 >> 8));
     Trace::printHex(uint8_t(crc16));
@@ -21,7 +21,9 @@ void Notify::change(key_t key, StateValue data)
 {
     amount_t i;
     for (i = 0; i < mListenerAmount; i++) {
-        mListener[i]->handleChange(0, key, data);
+        if (mListener[i]->isSubscribed(key)) {
+            mListener[i]->callHandleChange(0, key, data);
+        }
     }
 }
 
@@ -0,0 +1,331 @@
+/**
+ * ---------------------------------------------------------------------------------------------------
+ * This software is licensed under the GNU LESSER GENERAL PUBLIC LICENSE Version 3. It is furnished
+ * "as is", without any support, and with no warranty, express or implied, as to its usefulness for
+ * any purpose.
+ *
+ * File:      NotifyKeys.h
+ * Purpose:   Keys of the notifications (lower case letters), of the configuration values (upper case
+ *            letters) and of further messages and commands (punctuation characters). NotifyTarget derives
+ *            from this class, thus the keys are used as NotifyTarget::TEMPERATURE_NOTIFICATION or
+ *            unqualified in notify targets. Separate from NotifyTarget, as StateValue needs the keys.
+ *
+ * Author:    Volker Böhm
+ * Copyright: Volker Böhm
+ * Version:   1.0
+ * ---------------------------------------------------------------------------------------------------
+ */
+
+#ifndef __NOTIFYKEYS_H
+#define __NOTIFYKEYS_H
+
+class NotifyKeys {
+public:
+
+    /**
+     * Notifies the server about the current communication state of the token bases RS485 protocol. States are
+     * documented in RS485State.h
+     */
+    static const key_t STATE_NOTIFICATION           = 'a';
+
+    /**
+     * Notifies about brightness in percent.
+     */
+    static const key_t BRIGHTNESS_NOTIFICATION      = 'b';
+
+    /**
+     * Notifies about clock changes. Will be reported every second
+     */
+    static const key_t CLOCK_NOTIFICATION           = 'c';
+
+    /**
+     * Notifies about any value currently debugging.
+     */
+    static const key_t DEBUG_INFO_NOTIFICATION      = 'd';
+
+    /**
+     * Notifies about errors while receiving messages
+     */
+    static const key_t RECEIVE_ERROR_NOTIFICATION   = 'e';
+
+    /**
+     * Notifies about humidity. Signed fixed point value in 1/100 percent (see StateValue::getDecimals)
+     */
+    static const key_t HUMIDITY_NOTIFICATION        = 'h';
+
+    /**
+     * Notifies about a run out timer
+     */
+    static const key_t TIMER_NOTIFICATION           = 'i';
+
+    /**
+     * Notifies about the amount of bytes between heap and stack never touched by the stack since reboot (stack
+     * high-water mark). Used for debugging
+     */
+    static const key_t STACK_LEFT_NOTIFICATION      = 'k';
+
+    /**
+     * Notifies about light state. Sends the amount of seconds the light will be switched on. If a 0 is send the light
+     * is switched off
+     */
+    static const key_t LIGHT_ON_NOTIFICATION        = 'l';
+
+    /**
+     * Notifies about a move. Value = 1 on movement and Value = 0 on no movement
+     */
+    static const key_t MOVEMENT_NOTIFICATION        = 'm';
+
+    /**
+     * Notifies about a move. Value = 1 on movement and Value = 0 on no movement. Used to distinguish movement detectors
+     * "m" type and "n" type
+     */
+    static const key_t ENTRY_MOVEMENT_NOTIFICATION  = 'n';
+
+    /**
+     * Notifies about window state - value == 1 window is open, value == 0 window is closed
+     */
+    static const key_t WINDOW_OPEN_NOTIFICATION     = 'o';
+
+    /**
+     * Notifies about air pressure. The value must be multiplied by 2 to get the pressure
+     */
+    static const key_t AIR_PRESSURE_NOTIFICATION    = 'p';
+
+    /**
+     * Notifies about a read error of a device (currently only DHT22)
+     */
+    static const key_t READ_ERROR_NOTIFICATION      = 'r';
+
+    /**
+     * Notifies about a system temperature. 't' is used for room temperature and 's' is used to measure internal
+     * temperatures to check system helth. Signed fixed point value in 1/100 degree celsius
+     */
+    static const key_t SYS_TEMPERATURE_NOTIFICATION = 's';
+
+    /**
+     * Notifies about a room temperature. 't' is used for room temperature and 's' is used to measure internal
+     * temperatures to check system health. Signed fixed point value in 1/100 degree celsius
+     */
+    static const key_t TEMPERATURE_NOTIFICATION     = 't';
+
+    /**
+     * Value of a diagnostic record. The values follow a DIAGNOSTIC_ID_NOTIFICATION in the order documented
+     * in Diagnostics.h
+     */
+    static const key_t DIAGNOSTIC_VALUE_NOTIFICATION = 'u';
+
+    /**
+     * Notifies about PWM output voltage dimming a light. Usually for debugging purposes
+     */
+    static const key_t LIGHT_VOLTAGE_NOTIFICATION   = 'v';
+
+    /**
+     * Notifies about water 0 = no water 1..15 water (the higher the less resistance and thus the more water)
+     */
+    static const key_t WATER_NOTIFICATION           = 'w';
+
+    /**
+     * Starts a diagnostic record. The high byte of the value is the diagnostic topic, the low byte the item number
+     * (for example the index of a notify target). See Diagnostics.h
+     */
+    static const key_t DIAGNOSTIC_ID_NOTIFICATION   = 'x';
+
+    /**
+     * Notifies about an acivity
+     */
+    static const key_t ACTIVITY_NOTIFICATION         = 'y';
+
+
+    /**
+     * Notifies about the space between heap and stack for the running sketch. Used for debugging
+     */
+    static const key_t MEM_LEFT_NOTIFICATION        = 'z';
+
+    /**
+     * Starts an aggregate record of a sensor (see Aggregate.h). The value is the notify key of the sensor
+     */
+    static const key_t AGGREGATE_ID_NOTIFICATION    = '#';
+
+    /**
+     * Value of an aggregate record. The values follow an AGGREGATE_ID_NOTIFICATION in the order minimum,
+     * maximum, mean, samples
+     */
+    static const key_t AGGREGATE_VALUE_NOTIFICATION = '$';
+
+    /**
+     * Age in seconds of a stored change. The following notification is the stored change (see History.h)
+     */
+    static const key_t HISTORY_AGE_NOTIFICATION     = '%';
+
+    /**
+     * Command to send the stored changes of a key again. The low byte of the value is the key, the high byte
+     * the amount of changes (0 = all), see History.h
+     */
+    static const key_t HISTORY_KEY                  = '&';
+
+    /**
+     * Brightness control of the light: 0 = hysteresis steps (see LightState), 1 = PI controller
+     * (see BrightnessControl)
+     */
+    static const key_t LIGHT_CONTROL_KEY            = '(';
+
+    /**
+     * Proportional gain of the PI brightness controller in 1/256 level per percent
+     */
+    static const key_t PROPORTIONAL_GAIN_KEY        = ')';
+
+    /**
+     * Integral gain of the PI brightness controller in 1/256 level per percent and dimming delay
+     */
+    static const key_t INTEGRAL_GAIN_KEY            = '*';
+
+    /**
+     * Progress of the light calibration in percent, 100 = finished, 0xFFFF = failed, no light measured.
+     * The finished calibration is followed by the points of the light curve (see LIGHT_CURVE_NOTIFICATION)
+     */
+    static const key_t LIGHT_CALIBRATION_NOTIFICATION = '+';
+
+    /**
+     * Point of the light curve: light level in the high byte, brightness in percent of the full on
+     * brightness in the low byte. Sent in the order 0% (start voltage), 25%, 50%, 75%, 100% (full on voltage)
+     */
+    static const key_t LIGHT_CURVE_NOTIFICATION     = '=';
+
+    /**
+     * Light levels reaching 25%, 50% and 75% of the full on brightness, measured by the calibration
+     * (ADJUST_LIGHT). Three consecutive keys '-', '.', '/', 0 = not measured
+     */
+    static const key_t LIGHT_CURVE_KEY              = '-';
+
+    /**
+     * Maximal amount of notified changes delivered per schedule tick (see Schedule::deliverChanges)
+     */
+    static const key_t EVENT_BUDGET_KEY             = '@';
+
+    /**
+     * Resolution of the DS18B20 temperature sensors in bits (9 .. 12, see DTBus)
+     */
+    static const key_t DT_RESOLUTION_KEY            = '[';
+
+    /**
+     * Seconds between two conversions of the DS18B20 temperature sensors (see DTBus)
+     */
+    static const key_t DT_PERIOD_KEY                = ']';
+
+    /**
+     * Oversampling mode of the BMP085 pressure sensor (0 = 1 sample .. 3 = 8 samples, see BMP085)
+     */
+    static const key_t BMP_OVERSAMPLING_KEY         = '^';
+
+    /**
+     * Address of the device (2..127). 0 is reserved for broadcast and 1 is reserved for the server/pc
+     */
+    static const key_t ADDRESS_KEY                  = 'A';
+
+    /**
+     * Maximum brightness in percent when light will not turn on (minimal 10%).
+     */
+    static const key_t MAXIMUM_BRIGHTNESS_KEY       = 'B';
+    static const key_t CLOCK_KEY                    = 'C';
+
+    /**
+     * Brighness adjust on evening event
+     */
+    static const key_t EVENING_BRIGHTNESS_KEY       = 'D';
+
+    static const key_t LED_STATUS_KEY               = 'E';
+    static const key_t FS20_COMMMAND                = 'F';
+    /**
+     * Time in seconds between two infos send from the arduino if nothing interessting happens
+     */
+    static const key_t CONFIG_INFO_PERIOD_KEY       = 'G';
+    /**
+     * Minimal AnalogWrite value where the lights are fully on
+     */
+    static const key_t FULL_ON_VOLTAGE_KEY          = 'H';
+    /**
+     * Brighness target to achieve in percent. Lower it to dim lights
+     */
+    static const key_t TARGET_BRIGHTNESS_KEY        = 'I';
+
+    /**
+     * Analog read value measured by the brightness sensor, when light is fully on.
+     * The brightness sensor will report brightness relative to this setting.
+     */
+    static const key_t FULL_ON_VALUE_KEY            = 'J';
+
+    /**
+     * Activity period on first movement
+     */
+    static const key_t INIT_LIGHT_TIME_KEY          = 'K';
+
+    /**
+     * Time an activity is set ot active on additional moves. Times are always added until the activity deactivates.
+     */
+    static const key_t INC_LIGHT_TIME_KEY           = 'L';
+
+    /**
+     * Maximal time an activity is active without additional moves
+     */
+    static const key_t MAX_LIGHT_TIME_KEY           = 'M';
+
+    /**
+     * Brightness setting at night.
+     */
+    static const key_t NIGHT_BRIGHTNESS_KEY         = 'N';
+
+    /**
+     * Minimal value where light is not off (minimally on)
+     */
+    static const key_t START_VOLTAGE_KEY            = 'O';
+    /**
+     * Delay in milliseconds between two dimming steps
+     */
+    static const key_t DIMMING_DELAY_KEY            = 'P';
+    /**
+     * Command to measure light intensity and adjust the settings
+     * {"R":30, "K": "Q", "V":1}
+     */
+    static const key_t ADJUST_LIGHT                 = 'Q';
+    static const key_t ROLLER_SHUTTER_KEY           = 'R';
+
+    /**
+     * Address of the server
+     */
+    static const key_t SERVER_ADDRESS_KEY           = 'S';
+    static const key_t ROLLER_TIME_KEY              = 'T';
+
+    /**
+     * Command to send a diagnostic dump to the server. The value selects the topic, see Diagnostics.h
+     */
+    static const key_t DIAGNOSTIC_KEY               = 'U';
+    
+    /**
+     * Switches the light on for a time period in seconds or off (0)
+     */
+    static const key_t SET_LIGHT_TIME               = 'V';
+
+    /**
+     * Additional time in "increases" an activity will last if it is triggered in a non active status.
+     * Use a value > 0, if the activity should always be activated by a sensor placed near the entrance.
+     * If it is activated without directly a person is already in the room and the light went off nevertheless.
+     */
+    static const key_t ROOM_SENSOR_ADD_INC_KEY      = 'W';
+
+    /**
+     * Bitmask of the switch status. Every bit corresponds to one switch.
+     */
+    static const key_t SWITCH_STATUS_KEY            = 'X';
+
+    /**
+     * Seconds between two reads of slow sensors (DHT, BMP085), at least 2 seconds
+     */
+    static const key_t SAMPLE_INTERVAL_KEY          = 'Y';
+
+    /**
+     * Key of the currently installed software version (send only)
+     */
+    static const key_t SOFTWARE_VERSION_KEY         = 'Z';
+};
+
+#endif // __NOTIFYKEYS_H
@@ -13,6 +13,7 @@
 #include "NotifyTarget.h"
 #include "Device.h"
 #include "Schedule.h"
+#include "Profile.h"
 
 value_t NotifyTarget::getConfigValue(key_t key)
 {
@@ -62,11 +63,68 @@ bool NotifyTarget::broadcast(key_t key, StateValue value)
 
 void NotifyTarget::notify(key_t key, StateValue value)
 {
-    Device::getNotify(mDeviceNo).change(key, value);
+    Schedule::postChange(mDeviceNo, key, value);
 }
 
 void NotifyTarget::notifyAllDevices(key_t key, StateValue value)
 {
-    Schedule::broadcastChange(0, key, value.toInt());
+    Schedule::postChange(EventQueue::ALL_DEVICES, key, value);
 }
 
+void NotifyTarget::checkAgainIn(uint16_t loops)
+{
+    mNextCheck = Schedule::getLoops() + loops;
+    Schedule::requestCheck(mNextCheck);
+}
+
+bool NotifyTarget::requestReport()
+{
+    return Schedule::requestReport(this);
+}
+
+void NotifyTarget::callCheckState(time_t loops)
+{
+    mNextCheck = loops + mCheckMask + 1;
+    if (mPhase != NO_PHASE) {
+        // Returns to the balanced phase after a deadline (checkAgainIn) or a deferred call
+        mNextCheck = Schedule::alignToPhase(this, mNextCheck);
+    }
+    if (mpProfile == 0 && !Schedule::isMeasuringCost()) {
+        checkState(loops);
+    } else {
+        uint32_t start = micros();
+        checkState(loops);
+        uint32_t duration = micros() - start;
+        if (mpProfile != 0) {
+            mpProfile->checkState.add(duration);
+        }
+        uint32_t cost = (duration + COST_UNIT_IN_MICROSECONDS - 1) / COST_UNIT_IN_MICROSECONDS;
+        if (cost > mCost) {
+            mCost = cost > MAX_COST ? MAX_COST : cost;
+        }
+    }
+}
+
+void NotifyTarget::callHandleChange(address_t senderAddress, key_t key, StateValue data)
+{
+    if (mpProfile == 0) {
+        handleChange(senderAddress, key, data);
+    } else {
+        uint32_t start = micros();
+        handleChange(senderAddress, key, data);
+        mpProfile->handleChange.add(micros() - start);
+    }
+}
+
+bool NotifyTarget::callNotifyServer(uint16_t loopCount)
+{
+    bool result;
+    if (mpProfile == 0) {
+        result = notifyServer(loopCount);
+    } else {
+        uint32_t start = micros();
+        result = notifyServer(loopCount);
+        mpProfile->notifyServer.add(micros() - start);
+    }
+    return result;
+}
@@ -22,7 +22,9 @@
 
 #include "StdInclude.h"
 
-class NotifyTarget {
+class TargetProfile;
+
+class NotifyTarget : public NotifyKeys {
 public:
 
     static const bool INVERTED      = true;
@@ -36,213 +38,42 @@ public:
     static const uint8_t CHECKSTATE_NORMAL  = 0x07;
     static const uint8_t CHECKSTATE_SELDOM  = 0x7F;
 
-
-    /**
-     * Notifies the server about the current communication state of the token bases RS485 protocol. States are
-     * documented in RS485State.h
-     */
-    static const key_t STATE_NOTIFICATION           = 'a';
-
-    /**
-     * Notifies about brightness in percent.
-     */
-    static const key_t BRIGHTNESS_NOTIFICATION      = 'b';
-
-    /**
-     * Notifies about clock changes. Will be reported every second
-     */
-    static const key_t CLOCK_NOTIFICATION           = 'c';
-
-    /**
-     * Notifies about any value currently debugging.
-     */
-    static const key_t DEBUG_INFO_NOTIFICATION      = 'd';
-
     /**
-     * Notifies about errors while receiving messages
+     * Phase of a target not yet balanced (see Schedule::balancePhases)
      */
-    static const key_t RECEIVE_ERROR_NOTIFICATION   = 'e';
+    static const uint8_t NO_PHASE           = 0xFF;
 
     /**
-     * Notifies about humidity. Fixed point floating value. The first byte is the integer digit, the second byte is the
-     * decimal digit (0..99 => ,0 .. ,99)
-     *
+     * Priority classes. Critical targets are called first in every tick (movement, dimming, radio IO).
+     * Background targets (slow sensors, displays) are deferred to the next tick, if the tick has used up
+     * TICK_BUDGET_IN_MICROSECONDS, but at most MAX_DEFERRED_LOOPS loops.
      */
-    static const key_t HUMIDITY_NOTIFICATION        = 'h';
+    static const uint8_t PRIORITY_CRITICAL   = 0;
+    static const uint8_t PRIORITY_NORMAL     = 1;
+    static const uint8_t PRIORITY_BACKGROUND = 2;
 
-    /**
-     * Notifies about a run out timer
-     */
-    static const key_t TIMER_NOTIFICATION           = 'i';
-
-    /**
-     * Notifies about light state. Sends the amount of seconds the light will be switched on. If a 0 is send the light
-     * is switched off
-     */
-    static const key_t LIGHT_ON_NOTIFICATION        = 'l';
-
-    /**
-     * Notifies about a move. Value = 1 on movement and Value = 0 on no movement
-     */
-    static const key_t MOVEMENT_NOTIFICATION        = 'm';
-
-    /**
-     * Notifies about a move. Value = 1 on movement and Value = 0 on no movement. Used to distinguish movement detectors
-     * "m" type and "n" type
-     */
-    static const key_t ENTRY_MOVEMENT_NOTIFICATION  = 'n';
-
-    /**
-     * Notifies about window state - value == 1 window is open, value == 0 window is closed
-     */
-    static const key_t WINDOW_OPEN_NOTIFICATION     = 'o';
+    static const uint32_t TICK_BUDGET_IN_MICROSECONDS = 6000;
+    static const uint16_t MAX_DEFERRED_LOOPS          = LOOPS_PER_SECOND;
 
     /**
-     * Notifies about air pressure. The value must be multiplied by 2 to get the pressure
+     * The cost (longest checkState call) is stored in units of 32 microseconds, up to 8 milliseconds
      */
-    static const key_t AIR_PRESSURE_NOTIFICATION    = 'p';
+    static const uint8_t COST_UNIT_IN_MICROSECONDS = 32;
+    static const uint8_t MAX_COST                  = 0xFF;
 
     /**
-     * Notifies about a read error of a device (currently only DHT22)
+     * Key subscription: a 64 bit mask with one bit per key 'a'..'z' (bits 0..25) and 'A'..'Z'
+     * (bits 26..51). All other keys share OTHER_KEYS_BIT.
      */
-    static const key_t READ_ERROR_NOTIFICATION      = 'r';
-
-    /**
-     * Notifies about a system temperature. 't' is used for room temperature and 's' is used to measure internal
-     * temperatures to check system helth
-     */
-    static const key_t SYS_TEMPERATURE_NOTIFICATION = 's';
-
-    /**
-     * Notifies about a room temperature. 't' is used for room temperature and 's' is used to measure internal
-     * temperatures to check system health
-     */
-    static const key_t TEMPERATURE_NOTIFICATION     = 't';
-
-    /**
-     * Notifies about PWM output voltage dimming a light. Usually for debugging purposes
-     */
-    static const key_t LIGHT_VOLTAGE_NOTIFICATION   = 'v';
-
-    /**
-     * Notifies about water 0 = no water 1..15 water (the higher the less resistance and thus the more water)
-     */
-    static const key_t WATER_NOTIFICATION           = 'w';
-
-    /**
-     * Notifies about an acivity
-     */
-    static const key_t ACTIVITY_NOTIFICATION         = 'y';
-
-
-    /**
-     * Notifies about the space between heap and stack for the running sketch. Used for debugging
-     */
-    static const key_t MEM_LEFT_NOTIFICATION        = 'z';
-
-    /**
-     * Address of the device (2..127). 0 is reserved for broadcast and 1 is reserved for the server/pc
-     */
-    static const key_t ADDRESS_KEY                  = 'A';
-
-    /**
-     * Maximum brightness in percent when light will not turn on (minimal 10%).
-     */
-    static const key_t MAXIMUM_BRIGHTNESS_KEY       = 'B';
-    static const key_t CLOCK_KEY                    = 'C';
-
-    /**
-     * Brighness adjust on evening event
-     */
-    static const key_t EVENING_BRIGHTNESS_KEY       = 'D';
-
-    static const key_t LED_STATUS_KEY               = 'E';
-    static const key_t FS20_COMMMAND                = 'F';
-    /**
-     * Time in seconds between two infos send from the arduino if nothing interessting happens
-     */
-    static const key_t CONFIG_INFO_PERIOD_KEY       = 'G';
-    /**
-     * Minimal AnalogWrite value where the lights are fully on
-     */
-    static const key_t FULL_ON_VOLTAGE_KEY          = 'H';
-    /**
-     * Brighness target to achieve in percent. Lower it to dim lights
-     */
-    static const key_t TARGET_BRIGHTNESS_KEY        = 'I';
-
-    /**
-     * Analog read value measured by the brightness sensor, when light is fully on.
-     * The brightness sensor will report brightness relative to this setting.
-     */
-    static const key_t FULL_ON_VALUE_KEY            = 'J';
-
-    /**
-     * Activity period on first movement
-     */
-    static const key_t INIT_LIGHT_TIME_KEY          = 'K';
-
-    /**
-     * Time an activity is set ot active on additional moves. Times are always added until the activity deactivates.
-     */
-    static const key_t INC_LIGHT_TIME_KEY           = 'L';
-
-    /**
-     * Maximal time an activity is active without additional moves
-     */
-    static const key_t MAX_LIGHT_TIME_KEY           = 'M';
-
-    /**
-     * Brightness setting at night.
-     */
-    static const key_t NIGHT_BRIGHTNESS_KEY         = 'N';
-
-    /**
-     * Minimal value where light is not off (minimally on)
-     */
-    static const key_t START_VOLTAGE_KEY            = 'O';
-    /**
-     * Delay in milliseconds between two dimming steps
-     */
-    static const key_t DIMMING_DELAY_KEY            = 'P';
-    /**
-     * Command to measure light intensity and adjust the settings
-     * {"R":30, "K": "Q", "V":1}
-     */
-    static const key_t ADJUST_LIGHT                 = 'Q';
-    static const key_t ROLLER_SHUTTER_KEY           = 'R';
-
-    /**
-     * Address of the server
-     */
-    static const key_t SERVER_ADDRESS_KEY           = 'S';
-    static const key_t ROLLER_TIME_KEY              = 'T';
-    
-    /**
-     * Switches the light on for a time period in seconds or off (0)
-     */
-    static const key_t SET_LIGHT_TIME               = 'V';
-
-    /**
-     * Additional time in "increases" an activity will last if it is triggered in a non active status.
-     * Use a value > 0, if the activity should always be activated by a sensor placed near the entrance.
-     * If it is activated without directly a person is already in the room and the light went off nevertheless.
-     */
-    static const key_t ROOM_SENSOR_ADD_INC_KEY      = 'W';
-
-    /**
-     * Bitmask of the switch status. Every bit corresponds to one switch.
-     */
-    static const key_t SWITCH_STATUS_KEY            = 'X';
-
-    /**
-     * Key of the currently installed software version (send only)
-     */
-    static const key_t SOFTWARE_VERSION_KEY         = 'Z';
+    static const uint8_t KEY_MASK_BYTES = 8;
+    static const uint8_t OTHER_KEYS_BIT = 52;
 
     NotifyTarget(device_t deviceNo = 0)
-    : mDeviceNo(deviceNo), mCheckMask(CHECKSTATE_NEVER)
-    { }
+    : mDeviceNo(deviceNo), mCheckMask(CHECKSTATE_NEVER), mPriority(PRIORITY_NORMAL), mNextCheck(0), mPhase(NO_PHASE),
+      mObjectSize(0), mCost(0), mpProfile(0)
+    {
+        subscribeAll();
+    }
 
     /**
      * Signal a change. Register change type so that the class is informed on change
@@ -269,6 +100,16 @@ public:
         return true;
     }
 
+    /**
+     * Sends a changed value to the server. Called by the schedule for a report requested by
+     * requestReport, before any periodic notifyServer call.
+     * @return true, if the report has been send
+     */
+    virtual bool sendReport()
+    {
+        return true;
+    }
+
     /**
      * Sets the moule number for multiple module installations
      * @pram deviceNo number of the device this object belongs to
@@ -333,14 +174,15 @@ public:
     bool broadcast(key_t key, StateValue value);
 
     /**
-     * Sends a notifycation to all other objects in the current device
+     * Sends a notifycation to all other objects in the current device. The notification is queued
+     * and delivered after the checkState calls of the current tick (see Schedule::postChange)
      * @param key indentifier of the value
      * @param value the new value
      */
     void notify(key_t key, StateValue value);
 
     /**
-     * Sends a notifycation to all other objects in all devices
+     * Sends a notifycation to all other objects in all devices. The notification is queued like notify
      * @param key indentifier of the value
      * @param value the new value
      */
@@ -367,7 +209,7 @@ public:
 
     /**
      * Sets the bit mask to check if checkState will be called.
-     * the checkstate function will be called if schedule loop cound & mask == 0.
+     * the checkstate function will be called every mask + 1 schedule loops (see checkAgainIn).
      * Exception: value 255 signal no calls at all
      * @param mask new mask to set
      */
@@ -385,12 +227,233 @@ public:
         return mCheckMask;
     }
 
+    /**
+     * Gets the schedule loop checkState is due next (lower 16 bits of the loop count)
+     * @return loop of the next checkState call
+     */
+    uint16_t getNextCheck()
+    {
+        return mNextCheck;
+    }
+
+    /**
+     * Sets the schedule loop checkState is due next. Used by the schedule on registration
+     * @param loop loop of the next checkState call (lower 16 bits of the loop count)
+     */
+    void setNextCheck(uint16_t loop)
+    {
+        mNextCheck = loop;
+    }
+
+    /**
+     * Gets the phase assigned by the schedule, the periodic checkState calls are kept in this phase
+     * @return slot of the load profile (see Schedule::balancePhases) or NO_PHASE
+     */
+    uint8_t getPhase()
+    {
+        return mPhase;
+    }
+
+    /**
+     * Sets the phase of the periodic checkState calls. Used by the schedule on phase balancing
+     * @param phase slot of the load profile or NO_PHASE
+     */
+    void setPhase(uint8_t phase)
+    {
+        mPhase = phase;
+    }
+
+    /**
+     * Checks, if checkState is due
+     * @param loops number of checkState loops since reboot
+     * @return true, if checkState must be called in this loop
+     */
+    bool isCheckDue(time_t loops)
+    {
+        return int16_t(uint16_t(loops) - mNextCheck) >= 0;
+    }
+
+    /**
+     * Checks, if checkState may be deferred to the next loop, because the tick budget is used up
+     * @param loops number of checkState loops since reboot
+     * @return true, if the target is a background target not deferred for too long
+     */
+    bool mayDefer(time_t loops)
+    {
+        return mPriority == PRIORITY_BACKGROUND && int16_t(uint16_t(loops) - mNextCheck) < MAX_DEFERRED_LOOPS;
+    }
+
+    /**
+     * Sets the priority class. Must be set before the target is registered (usually in the constructor)
+     * @param priority PRIORITY_CRITICAL, PRIORITY_NORMAL or PRIORITY_BACKGROUND
+     */
+    void setPriority(uint8_t priority)
+    {
+        mPriority = priority;
+    }
+
+    /**
+     * Gets the priority class
+     * @return PRIORITY_CRITICAL, PRIORITY_NORMAL or PRIORITY_BACKGROUND
+     */
+    uint8_t getPriority()
+    {
+        return mPriority;
+    }
+
+    /**
+     * Subscribes all keys, handleChange is called for every change. This is the default for new targets.
+     */
+    void subscribeAll()
+    {
+        for (uint8_t index = 0; index < KEY_MASK_BYTES; index++) {
+            mKeyMask[index] = 0xFF;
+        }
+    }
+
+    /**
+     * Removes all subscriptions, handleChange is not called any more. Use subscribe to add the keys
+     * handled by the target.
+     */
+    void unsubscribeAll()
+    {
+        for (uint8_t index = 0; index < KEY_MASK_BYTES; index++) {
+            mKeyMask[index] = 0;
+        }
+    }
+
+    /**
+     * Subscribes a key, handleChange is called for changes of the key
+     * @param key key handled by the target
+     */
+    void subscribe(key_t key)
+    {
+        uint8_t bit = getKeyBit(key);
+        mKeyMask[bit >> 3] |= 1 << (bit & 7);
+    }
+
+    /**
+     * Checks, if a key is subscribed
+     * @param key key of a change
+     * @return true, if handleChange must be called for the key
+     */
+    bool isSubscribed(key_t key)
+    {
+        uint8_t bit = getKeyBit(key);
+        return (mKeyMask[bit >> 3] & (1 << (bit & 7))) != 0;
+    }
+
+    /**
+     * Gets the bit of a key in the subscription mask
+     * @param key key to get the bit for
+     * @return bit number 0..OTHER_KEYS_BIT
+     */
+    static uint8_t getKeyBit(key_t key)
+    {
+        uint8_t bit = OTHER_KEYS_BIT;
+        if (key >= 'a' && key <= 'z') {
+            bit = key - 'a';
+        } else if (key >= 'A' && key <= 'Z') {
+            bit = key - 'A' + 26;
+        }
+        return bit;
+    }
+
+    /**
+     * Declares the next time checkState is due. Without a call, checkState is due again
+     * after getCheckMask() + 1 loops. May be called in checkState to sleep longer or from
+     * handleChange to be checked earlier.
+     * @param loops amount of loops to wait (below 32768), 0 = check in the current/next loop
+     */
+    void checkAgainIn(uint16_t loops);
+
+    /**
+     * Requests to report a changed value to the server (see sendReport). Pending reports are sent
+     * ordered by priority class and age, as soon as the device may send.
+     * @return true, if the report is pending, false if too many reports are pending
+     */
+    bool requestReport();
+
+    /**
+     * Sets the size of the object in RAM. It is set on registration (see SpikeHome::addToSchedule)
+     * @param objectSize size of the object in bytes (sizeof of the derived class)
+     */
+    void setObjectSize(uint16_t objectSize)
+    {
+        mObjectSize = objectSize;
+    }
+
+    /**
+     * Gets the size of the object in RAM
+     * @return size of the object in bytes or 0 if unknown
+     */
+    uint16_t getObjectSize()
+    {
+        return mObjectSize;
+    }
+
+    /**
+     * Sets the execution time statistics. Once set, the calls below measure the execution time
+     * (see Schedule::startProfiling)
+     * @param pProfile statistics to fill
+     */
+    void setProfile(TargetProfile* pProfile)
+    {
+        mpProfile = pProfile;
+    }
+
+    /**
+     * Gets the execution time statistics
+     * @return statistics or 0, if the target is not profiled
+     */
+    TargetProfile* getProfile()
+    {
+        return mpProfile;
+    }
+
+    /**
+     * Gets the longest checkState call measured while the schedule measures costs (see Schedule::balancePhases)
+     * @return longest checkState call in microseconds
+     */
+    uint16_t getCost()
+    {
+        return uint16_t(mCost) * COST_UNIT_IN_MICROSECONDS;
+    }
+
+    /**
+     * Calls checkState and measures its execution time, if profiling is enabled or costs are measured
+     * @param loops number of checkState loops since reboot
+     */
+    void callCheckState(time_t loops);
+
+    /**
+     * Calls handleChange and measures its execution time, if profiling is enabled
+     * @param senderAddress address of the sender
+     * @param key key/identifier of the change
+     * @param data new value
+     */
+    void callHandleChange(address_t senderAddress, key_t key, StateValue data);
+
+    /**
+     * Calls notifyServer and measures its execution time, if profiling is enabled
+     * @param loopCount amount of notify loops already passed
+     * @return result of notifyServer
+     */
+    bool callNotifyServer(uint16_t loopCount);
+
 
 private:
 
     device_t mDeviceNo;
     NotifyTarget* next;
     uint8_t  mCheckMask;
+    uint8_t  mPriority;
+    uint16_t mNextCheck;
+    uint8_t  mPhase;
+    uint16_t mObjectSize;
+    uint8_t  mCost;
+    TargetProfile* mpProfile;
+    uint8_t  mKeyMask[KEY_MASK_BYTES];
 };
 
 #endif // __NOTIFYTARGET_H
@@ -5,8 +5,8 @@
  * any purpose.
  *
  * File:      NotifyTargetList.h
- * Purpose:   Helper file for Schedule. Holds a list of NotifyTargets. Each Targets has a timer-count
- * attachted to it to signal/show when to call its checkState Method
+ * Purpose:   Helper file for Schedule. Holds a list of NotifyTargets. Each Targets has the loop of its
+ * next checkState call attachted to it to signal/show when to call its checkState Method
  *
  * Author:    Volker Böhm
  * Copyright: Volker Böhm
@@ -27,16 +27,29 @@ class NotifyTargetList {
 public:
 
 
-    NotifyTargetList() : first(0) { };
+    NotifyTargetList() : first(0), amount(0), mHandleChangeCalls(0), mHandleChangeSkips(0) { };
 
     /**
-     * Adds an element to the target list
+     * Adds an element to the target list. The list is sorted by priority, the element is added in front
+     * of the targets with the same priority. The first checkState call is delayed by the amount of
+     * targets already registered to spread the calls of targets with the same check mask
      * @param target
      */
     void add(NotifyTarget* target)
     {
-        target->setNext(first);
-        first = target;
+        NotifyTarget* prev = 0;
+        NotifyTarget* cur;
+        for (cur = first; cur != 0 && cur->getPriority() < target->getPriority(); cur = cur->getNext()) {
+            prev = cur;
+        }
+        target->setNext(cur);
+        if (prev == 0) {
+            first = target;
+        } else {
+            prev->setNext(target);
+        }
+        target->setNextCheck(amount);
+        amount++;
     }
 
     /**
@@ -53,23 +66,52 @@ public:
     }
 
     /**
-     * Calls checkState functions if timer runs to zero.
+     * Calls checkState functions of all targets being due. Background targets are deferred, if the
+     * tick budget is used up.
      * @param loops number of checkState loops since reboot
+     * @param nextCheck latest loop to return
+     * @param tickStartInMicroseconds start of the current tick
+     * @param deferred output: incremented for every deferred checkState call
+     * @return loop the next checkState call is due (lower 16 bits of the loop count)
      */
-    void callCheckState(time_t loops)
+    uint16_t callCheckState(time_t loops, uint16_t nextCheck, uint32_t tickStartInMicroseconds, uint16_t& deferred)
     {
         NotifyTarget* cur;
         for (cur = first; cur!= 0; cur = cur->getNext()) {
-            uint8_t mask = cur->getCheckMask();
-            if ((loops & mask) == 0 && mask != NotifyTarget::CHECKSTATE_NEVER) {
-                cur->checkState(loops);
+            if (cur->getCheckMask() == NotifyTarget::CHECKSTATE_NEVER) {
+                continue;
             }
-            loops ++;
+            if (cur->isCheckDue(loops)) {
+                bool overBudget = micros() - tickStartInMicroseconds > NotifyTarget::TICK_BUDGET_IN_MICROSECONDS;
+                if (overBudget && cur->mayDefer(loops)) {
+                    deferred++;
+                } else {
+                    cur->callCheckState(loops);
+                }
+            }
+            if (int16_t(cur->getNextCheck() - nextCheck) < 0) {
+                nextCheck = cur->getNextCheck();
+            }
+        }
+        return nextCheck;
+    }
+
+    /**
+     * Restarts the checkState calls of all targets spread over the following loops
+     * @param loops number of checkState loops since reboot
+     */
+    void restartChecks(time_t loops)
+    {
+        NotifyTarget* cur;
+        uint16_t nextCheck = loops;
+        for (cur = first; cur!= 0; cur = cur->getNext()) {
+            cur->setNextCheck(nextCheck);
+            nextCheck++;
         }
     }
 
     /**
-     * Notifies all objects/sensors of a device of a configuration change
+     * Notifies all objects/sensors of a device subscribing the key of a configuration change
      * @param deviceNo number of device
      * @param senderAddress address of the sender
      * @param key key/identifier of the change
@@ -80,11 +122,46 @@ public:
         NotifyTarget* cur;
         for (cur = first; cur!= 0; cur = cur->getNext()) {
             if (cur->getDeviceNo() == deviceNo) {
-                cur->handleChange(senderAddress, key, value);
+                notifyTarget(cur, senderAddress, key, value);
             }
         }
     }
 
+    /**
+     * Notifies all objects/sensors of all devices subscribing the key of a change
+     * @param deviceAmount amount of devices
+     * @param senderAddress address of the sender
+     * @param key key/identifier of the change
+     * @param value new value
+     */
+    void notifyAllDevices(device_t deviceAmount, address_t senderAddress, key_t key, value_t value)
+    {
+        NotifyTarget* cur;
+        for (cur = first; cur!= 0; cur = cur->getNext()) {
+            if (cur->getDeviceNo() < deviceAmount) {
+                notifyTarget(cur, senderAddress, key, value);
+            }
+        }
+    }
+
+    /**
+     * Gets the amount of handleChange calls
+     * @return amount of calls (saturates at 65535)
+     */
+    uint16_t getHandleChangeCalls()
+    {
+        return mHandleChangeCalls;
+    }
+
+    /**
+     * Gets the amount of handleChange calls saved, because the target does not subscribe the key
+     * @return amount of calls (saturates at 65535)
+     */
+    uint16_t getHandleChangeSkips()
+    {
+        return mHandleChangeSkips;
+    }
+
     /**
      * Gets the first notify target in the list
      * @return
@@ -95,7 +172,30 @@ public:
     }
 
 private:
+
+    /**
+     * Calls handleChange of a target, if it subscribes the key
+     * @param target target to notify
+     * @param senderAddress address of the sender
+     * @param key key/identifier of the change
+     * @param value new value
+     */
+    void notifyTarget(NotifyTarget* target, address_t senderAddress, key_t key, value_t value)
+    {
+        if (target->isSubscribed(key)) {
+            target->callHandleChange(senderAddress, key, value);
+            if (mHandleChangeCalls < 0xFFFF) {
+                mHandleChangeCalls++;
+            }
+        } else if (mHandleChangeSkips < 0xFFFF) {
+            mHandleChangeSkips++;
+        }
+    }
+
     NotifyTarget* first;
+    list_t amount;
+    uint16_t mHandleChangeCalls;
+    uint16_t mHandleChangeSkips;
 };
 
 
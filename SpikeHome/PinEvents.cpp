@@ -0,0 +1,99 @@
+/**
+ * ---------------------------------------------------------------------------------------------------
+ * This software is licensed under the GNU LESSER GENERAL PUBLIC LICENSE Version 3. It is furnished
+ * "as is", without any support, and with no warranty, express or implied, as to its usefulness for
+ * any purpose.
+ *
+ * File:      PinEvents.cpp
+ *
+ * Author:    Volker Böhm
+ * Copyright: Volker Böhm
+ * Version:   1.0
+ * ---------------------------------------------------------------------------------------------------
+ */
+
+#include "PinEvents.h"
+#include "State.h"
+
+State*                      PinEvents::mpState[MAX_SOURCES];
+volatile uint8_t*           PinEvents::mpInput[MAX_SOURCES];
+uint8_t                     PinEvents::mBitMask[MAX_SOURCES];
+volatile uint8_t            PinEvents::mLastLevel[MAX_SOURCES];
+uint8_t                     PinEvents::mSources;
+volatile PinEvents::Event   PinEvents::mBuffer[BUFFER_SIZE];
+volatile uint8_t            PinEvents::mHead;
+volatile uint8_t            PinEvents::mTail;
+volatile uint8_t            PinEvents::mOverflows;
+volatile bool               PinEvents::mLost;
+uint16_t                    PinEvents::mDispatched;
+TickHistogram               PinEvents::mLatencyHistogram;
+
+bool PinEvents::attach(pin_t pin, State* pState)
+{
+    static void (* const handlers[MAX_SOURCES])() = { onEdge0, onEdge1, onEdge2, onEdge3 };
+    bool result = false;
+#ifdef digitalPinToInterrupt
+    int8_t interruptNo = digitalPinToInterrupt(pin);
+    if (interruptNo != NOT_AN_INTERRUPT && mSources < MAX_SOURCES) {
+        uint8_t source = mSources;
+        mpState[source] = pState;
+        mpInput[source] = portInputRegister(digitalPinToPort(pin));
+        mBitMask[source] = digitalPinToBitMask(pin);
+        mLastLevel[source] = readLevel(source);
+        mSources++;
+        attachInterrupt(interruptNo, handlers[source], CHANGE);
+        result = true;
+    }
+#endif
+    return result;
+}
+
+void PinEvents::capture(uint8_t source)
+{
+    time_t timeInMilliseconds = millis();
+    uint8_t level = readLevel(source);
+    if (level == mLastLevel[source]) {
+        push(source, level == HIGH ? LOW : HIGH, timeInMilliseconds);
+    }
+    push(source, level, timeInMilliseconds);
+    mLastLevel[source] = level;
+}
+
+void PinEvents::push(uint8_t source, uint8_t level, time_t timeInMilliseconds)
+{
+    uint8_t next = (mHead + 1) & BUFFER_MASK;
+    if (next == mTail) {
+        mLost = true;
+        if (mOverflows < MAX_OVERFLOWS) {
+            mOverflows++;
+        }
+    } else {
+        mBuffer[mHead].source = source;
+        mBuffer[mHead].level = level;
+        mBuffer[mHead].timeInMilliseconds = timeInMilliseconds;
+        // Publishes the event after it is written completely
+        mHead = next;
+    }
+}
+
+void PinEvents::dispatch()
+{
+    while (mTail != mHead) {
+        uint8_t source = mBuffer[mTail].source;
+        uint8_t level = mBuffer[mTail].level;
+        time_t timeInMilliseconds = mBuffer[mTail].timeInMilliseconds;
+        // Frees the slot after it is read completely
+        mTail = (mTail + 1) & BUFFER_MASK;
+        mLatencyHistogram.add(millis() - timeInMilliseconds);
+        if (mDispatched < 0xFFFF) {
+            mDispatched++;
+        }
+        mpState[source]->handleEdge(level);
+    }
+    if (mLost) {
+        mLost = false;
+        for (uint8_t source = 0; source < mSources; source++) {
+            mpState[source]->handleEdge(readLevel(source));
+        }
+    }
+}
@@ -0,0 +1,131 @@
+/**
+ * ---------------------------------------------------------------------------------------------------
+ * This software is licensed under the GNU LESSER GENERAL PUBLIC LICENSE Version 3. It is furnished
+ * "as is", without any support, and with no warranty, express or implied, as to its usefulness for
+ * any purpose.
+ *
+ * File:      PinEvents.h
+ * Purpose:   Interrupt driven capture of pin edges. The interrupt handler reads the pin level,
+ *            timestamps it and writes it to a ring buffer. The schedule drains the buffer every tick
+ *            and forwards the events to the State objects owning the pins. Thus edges are processed
+ *            on the next tick (<= 10 ms) and short pulses are not missed.
+ *            The ring buffer has a single producer (interrupt) and a single consumer (schedule): the
+ *            interrupt only writes mHead, the schedule only writes mTail. Both are single bytes and
+ *            thus read and written atomically, no interrupt lock is needed.
+ *            Pins are captured with the external interrupts (INTx, attachInterrupt). The pin change
+ *            interrupt vectors are owned by SoftwareSerial (used by FS20UART) and cannot be shared.
+ *            Pins without external interrupt are still polled by their State objects.
+ *
+ * Author:    Volker Böhm
+ * Copyright: Volker Böhm
+ * Version:   1.0
+ * ---------------------------------------------------------------------------------------------------
+ */
+
+#ifndef __PINEVENTS_H
+#define __PINEVENTS_H
+
+#include "StdInclude.h"
+#include "Profile.h"
+
+class State;
+
+class PinEvents {
+public:
+
+    /**
+     * Maximal amount of pins captured, the ATmega328 has two external interrupts, the ATmega2560 six
+     */
+    static const uint8_t MAX_SOURCES = 4;
+
+    /**
+     * Registers a pin for edge capture
+     * @param pin pin to capture
+     * @param pState state object to receive the edges of the pin
+     * @return true, if the pin is captured, false if the pin has no external interrupt or all sources are used
+     */
+    static bool attach(pin_t pin, State* pState);
+
+    /**
+     * Forwards all captured edges to the state objects, called by the schedule every tick.
+     * If edges have been lost due to a full buffer, all state objects get their current pin level.
+     */
+    static void dispatch();
+
+    /**
+     * Gets the amount of edges forwarded to state objects
+     * @return amount of edges (saturates at 65535)
+     */
+    static uint16_t getDispatched() { return mDispatched; }
+
+    /**
+     * Gets the amount of edges lost due to a full buffer
+     * @return amount of edges (saturates at 255)
+     */
+    static uint8_t getOverflows() { return mOverflows; }
+
+    /**
+     * Gets the histogram of the time between edge and dispatch
+     */
+    static const TickHistogram& getLatencyHistogram() { return mLatencyHistogram; }
+
+private:
+    PinEvents() {}
+
+    static const uint8_t BUFFER_SIZE = 8;
+    static const uint8_t BUFFER_MASK = BUFFER_SIZE - 1;
+    static const uint8_t MAX_OVERFLOWS = 0xFF;
+
+    struct Event {
+        uint8_t source;
+        uint8_t level;
+        time_t  timeInMilliseconds;
+    };
+
+    /**
+     * Interrupt handler: reads the level of a source and writes the edge to the buffer. If the level did not
+     * change, the pin had a pulse shorter than the interrupt latency and both edges are written.
+     * @param source index of the source
+     */
+    static void capture(uint8_t source);
+
+    /**
+     * Interrupt handler: writes an edge to the buffer
+     * @param source index of the source
+     * @param level level after the edge
+     * @param timeInMilliseconds time of the edge
+     */
+    static void push(uint8_t source, uint8_t level, time_t timeInMilliseconds);
+
+    /**
+     * Reads the current level of a source
+     * @param source index of the source
+     * @return HIGH or LOW
+     */
+    static uint8_t readLevel(uint8_t source)
+    {
+        return (*mpInput[source] & mBitMask[source]) != 0 ? HIGH : LOW;
+    }
+
+    static void onEdge0() { capture(0); }
+    static void onEdge1() { capture(1); }
+    static void onEdge2() { capture(2); }
+    static void onEdge3() { capture(3); }
+
+    static State*                   mpState[MAX_SOURCES];
+    static volatile uint8_t*        mpInput[MAX_SOURCES];
+    static uint8_t                  mBitMask[MAX_SOURCES];
+    static volatile uint8_t         mLastLevel[MAX_SOURCES];
+    static uint8_t                  mSources;
+
+    static volatile Event           mBuffer[BUFFER_SIZE];
+    static volatile uint8_t         mHead;
+    static volatile uint8_t         mTail;
+    static volatile uint8_t         mOverflows;
+    static volatile bool            mLost;
+
+    static uint16_t                 mDispatched;
+    static TickHistogram            mLatencyHistogram;
+};
+
+#endif // __PINEVENTS_H
@@ -0,0 +1,137 @@
+/**
+ * ---------------------------------------------------------------------------------------------------
+ * This software is licensed under the GNU LESSER GENERAL PUBLIC LICENSE Version 3. It is furnished
+ * "as is", without any support, and with no warranty, express or implied, as to its usefulness for
+ * any purpose.
+ *
+ * File:      Profile.h
+ * Purpose:   Execution time statistics. CallProfile collects minimum, maximum, moving average and
+ *            overruns of the execution time of one method. TargetProfile holds the statistics of
+ *            the three methods called by the framework for a NotifyTarget. TickHistogram counts
+ *            tick related times (lag, overrun) in buckets of powers of two milliseconds.
+ *
+ * Author:    Volker Böhm
+ * Copyright: Volker Böhm
+ * Version:   1.0
+ * ---------------------------------------------------------------------------------------------------
+ */
+
+#ifndef __PROFILE_H
+#define __PROFILE_H
+
+#include <Arduino.h>
+
+class CallProfile {
+public:
+
+    /**
+     * A call lasting longer than one schedule tick (10 milliseconds) is counted as overrun
+     */
+    static const uint16_t OVERRUN_IN_MICROSECONDS = 10000;
+    static const uint16_t MAX_DURATION            = 0xFFFF;
+    static const uint8_t  MAX_OVERRUNS            = 0xFF;
+
+    CallProfile() : mMin(MAX_DURATION), mMax(0), mMean(0), mOverruns(0) {}
+
+    /**
+     * Adds the duration of a call to the statistics
+     * @param durationInMicroseconds duration of the call
+     */
+    void add(uint32_t durationInMicroseconds)
+    {
+        uint16_t duration = durationInMicroseconds > MAX_DURATION ? MAX_DURATION : durationInMicroseconds;
+        if (duration < mMin) {
+            mMin = duration;
+        }
+        if (duration > mMax) {
+            mMax = duration;
+        }
+        // Moving average, each call has a weight of 1/8
+        mMean = (int32_t(mMean) * 7 + duration) / 8;
+        if (duration > OVERRUN_IN_MICROSECONDS && mOverruns < MAX_OVERRUNS) {
+            mOverruns++;
+        }
+    }
+
+    /**
+     * Gets the shortest duration measured
+     * @return duration in microseconds, 0 if nothing has been measured
+     */
+    uint16_t getMin() const { return mMin == MAX_DURATION && mMax == 0 ? 0 : mMin; }
+
+    /**
+     * Gets the longest duration measured
+     * @return duration in microseconds
+     */
+    uint16_t getMax() const { return mMax; }
+
+    /**
+     * Gets the moving average of the duration
+     * @return duration in microseconds
+     */
+    uint16_t getMean() const { return mMean; }
+
+    /**
+     * Gets the amount of calls lasting longer than OVERRUN_IN_MICROSECONDS
+     * @return amount of overruns (saturates at 255)
+     */
+    uint8_t getOverruns() const { return mOverruns; }
+
+private:
+    uint16_t mMin;
+    uint16_t mMax;
+    uint16_t mMean;
+    uint8_t  mOverruns;
+};
+
+class TargetProfile {
+public:
+    CallProfile checkState;
+    CallProfile handleChange;
+    CallProfile notifyServer;
+};
+
+class TickHistogram {
+public:
+
+    static const uint8_t BUCKETS = 8;
+
+    TickHistogram()
+    {
+        for (uint8_t bucket = 0; bucket < BUCKETS; bucket++) {
+            mCount[bucket] = 0;
+        }
+    }
+
+    /**
+     * Counts a time. Bucket 0 counts times below 1 ms, bucket 1 below 2 ms, bucket 2 below 4 ms, ...
+     * the last bucket counts all larger times.
+     * @param timeInMilliseconds time to count
+     */
+    void add(uint32_t timeInMilliseconds)
+    {
+        uint8_t bucket = 0;
+        while (timeInMilliseconds > 0 && bucket < BUCKETS - 1) {
+            timeInMilliseconds >>= 1;
+            bucket++;
+        }
+        if (mCount[bucket] < 0xFFFF) {
+            mCount[bucket]++;
+        }
+    }
+
+    /**
+     * Gets the amount of times counted in a bucket
+     * @param bucket index of the bucket
+     * @return amount of times counted (saturates at 65535)
+     */
+    uint16_t getCount(uint8_t bucket) const
+    {
+        return bucket < BUCKETS ? mCount[bucket] : 0;
+    }
+
+private:
+    uint16_t mCount[BUCKETS];
+};
+
+#endif // __PROFILE_H
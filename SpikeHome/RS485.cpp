@@ -14,6 +14,7 @@
 
 //#define DEBUG
 #include "RS485.h"
+#include "Memory.h"
 
 RS485::RS485(device_t deviceAmount, pin_t readWritePin)
  :SerialIO(deviceAmount)
@@ -123,6 +124,7 @@ void RS485::handleNewTokenState(value_t stateType, uint8_t messageVersion)
         if (stateType == RS485State::REGISTRATION_INFO || (mStateChanged && maySend() )) {
             sendToServer(0, NotifyTarget::STATE_NOTIFICATION, value_t(mState.getState()) * 0x100 + mState.getReceiverAddress());
             sendToServer(0, NotifyTarget::MEM_LEFT_NOTIFICATION, Trace::getFreeMemory());
+            sendToServer(0, NotifyTarget::STACK_LEFT_NOTIFICATION, Memory::getUnusedStack());
             mStateChanged = false;
         }
         if (stateType == RS485State::PASS_SEND_TOKEN_TO_NEXT_DEVICE) {
@@ -48,6 +48,15 @@ public:
         return mState.maySend();
     }
 
+    /**
+     * Checks if the token ring is established
+     * @return true, if the state is stable
+     */
+    virtual bool isConnected()
+    {
+        return mState.isStable();
+    }
+
 
 private:
 
@@ -93,6 +93,15 @@ public:
         return mState != STATE_STABLE;
     }
 
+    /**
+     * Checks, if the token ring communication is established
+     * @return true, if the state is STATE_STABLE
+     */
+    bool isStable()
+    {
+        return mState == STATE_STABLE;
+    }
+
 private:
 
 
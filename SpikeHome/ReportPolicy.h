@@ -0,0 +1,119 @@
+/**
+ * ---------------------------------------------------------------------------------------------------
+ * This software is licensed under the GNU LESSER GENERAL PUBLIC LICENSE Version 3. It is furnished
+ * "as is", without any support, and with no warranty, express or implied, as to its usefulness for
+ * any purpose.
+ *
+ * File:      ReportPolicy.h
+ * Purpose:   Decides when a sensor value is reported: a change must exceed an absolute and a relative
+ *            deadband, two reports have a minimal interval and a value is reported at least every
+ *            heartbeat interval, even if it did not change.
+ *            The parameters are stored in the configuration of the device (see State::setReportPolicy).
+ *            Their keys are derived from the notify key of the sensor ('a' .. 'z'):
+ *            0x80 | parameter << 5 | (notifyKey - 'a'). Example: the heartbeat of the brightness
+ *            sensor ('b') has the key 0x80 | 3 << 5 | 1 = 0xE1.
+ *            Values of keys with decimals (temperatures, humidity) are signed, their deadbands are
+ *            checked in signed arithmetic (see setSigned).
+ *
+ * Author:    Volker Böhm
+ * Copyright: Volker Böhm
+ * Version:   1.0
+ * ---------------------------------------------------------------------------------------------------
+ */
+
+#ifndef __REPORTPOLICY_H
+#define __REPORTPOLICY_H
+
+#include "StdInclude.h"
+
+class ReportPolicy {
+public:
+
+    /**
+     * Parameters
+     * ABSOLUTE: a change must be larger than this value
+     * RELATIVE_PERCENT: a change must be at least this percentage of the current value
+     * MIN_INTERVAL: minimal seconds between two reports
+     * HEARTBEAT: maximal seconds without a report, 0 = no heartbeat
+     */
+    static const uint8_t ABSOLUTE           = 0;
+    static const uint8_t RELATIVE_PERCENT   = 1;
+    static const uint8_t MIN_INTERVAL       = 2;
+    static const uint8_t HEARTBEAT          = 3;
+    static const uint8_t PARAMETERS         = 4;
+
+    static const key_t   NO_POLICY_KEY      = 0;
+
+    /**
+     * Default policy: every change is reported, at most every 5 seconds, no heartbeat
+     */
+    ReportPolicy() : mSigned(false)
+    {
+        mParameter[ABSOLUTE] = 0;
+        mParameter[RELATIVE_PERCENT] = 0;
+        mParameter[MIN_INTERVAL] = 5;
+        mParameter[HEARTBEAT] = 0;
+    }
+
+    /**
+     * Gets a parameter
+     * @param parameter ABSOLUTE .. HEARTBEAT
+     */
+    value_t get(uint8_t parameter) const { return mParameter[parameter]; }
+
+    /**
+     * Sets a parameter
+     * @param parameter ABSOLUTE .. HEARTBEAT
+     * @param value new value
+     */
+    void set(uint8_t parameter, value_t value) { mParameter[parameter] = value; }
+
+    /**
+     * Sets the interpretation of the values
+     * @param isSigned true, if the values are signed (see StateValue::toSigned)
+     */
+    void setSigned(bool isSigned) { mSigned = isSigned; }
+
+    /**
+     * Checks, if a change exceeds both deadbands
+     * @param curValue current value
+     * @param lastValue last value reported
+     * @return true, if the change must be reported
+     */
+    bool exceedsDeadband(value_t curValue, value_t lastValue) const
+    {
+        uint32_t difference;
+        uint32_t magnitude;
+        if (mSigned) {
+            int32_t signedDifference = int32_t(int16_t(curValue)) - int16_t(lastValue);
+            int32_t signedValue = int16_t(curValue);
+            difference = signedDifference < 0 ? -signedDifference : signedDifference;
+            magnitude = signedValue < 0 ? -signedValue : signedValue;
+        } else {
+            difference = curValue > lastValue ? curValue - lastValue : lastValue - curValue;
+            magnitude = curValue;
+        }
+        return difference > mParameter[ABSOLUTE] &&
+            difference * 100 >= magnitude * mParameter[RELATIVE_PERCENT];
+    }
+
+    /**
+     * Derives the configuration key of a parameter from the notify key of a sensor
+     * @param notifyKey notify key of the sensor ('a' .. 'z')
+     * @param parameter ABSOLUTE .. HEARTBEAT
+     * @return configuration key, NO_POLICY_KEY if the notify key is no lower case letter
+     */
+    static key_t getKey(key_t notifyKey, uint8_t parameter)
+    {
+        if (notifyKey < 'a' || notifyKey > 'z') {
+            return NO_POLICY_KEY;
+        }
+        return 0x80 | (parameter << 5) | (notifyKey - 'a');
+    }
+
+private:
+    value_t mParameter[PARAMETERS];
+    bool    mSigned;
+};
+
+#endif // __REPORTPOLICY_H
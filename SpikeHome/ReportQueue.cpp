@@ -0,0 +1,71 @@
+/**
+ * ---------------------------------------------------------------------------------------------------
+ * This software is licensed under the GNU LESSER GENERAL PUBLIC LICENSE Version 3. It is furnished
+ * "as is", without any support, and with no warranty, express or implied, as to its usefulness for
+ * any purpose.
+ *
+ * File:      ReportQueue.cpp
+ *
+ * Author:    Volker Böhm
+ * Copyright: Volker Böhm
+ * Version:   1.0
+ * ---------------------------------------------------------------------------------------------------
+ */
+
+#include "ReportQueue.h"
+
+bool ReportQueue::add(NotifyTarget* pTarget)
+{
+    for (uint8_t index = 0; index < mAmount; index++) {
+        if (mpTarget[index] == pTarget) {
+            return true;
+        }
+    }
+    bool result = mAmount < SIZE;
+    if (result) {
+        mpTarget[mAmount] = pTarget;
+        mQueuedAt[mAmount] = millis();
+        mAmount++;
+    } else if (mRejected < MAX_COUNT) {
+        mRejected++;
+    }
+    return result;
+}
+
+bool ReportQueue::sendNext()
+{
+    if (mAmount == 0) {
+        return false;
+    }
+    // The queue keeps the order of arrival, thus the first report of the best class is the oldest
+    uint8_t best = 0;
+    for (uint8_t index = 1; index < mAmount; index++) {
+        if (mpTarget[index]->getPriority() < mpTarget[best]->getPriority()) {
+            best = index;
+        }
+    }
+    uint16_t age = getAge(best);
+    if (mpTarget[best]->sendReport()) {
+        mMaxAgeInMilliseconds = max(mMaxAgeInMilliseconds, age);
+        if (mSent < MAX_COUNT) {
+            mSent++;
+        }
+        mAmount--;
+        for (uint8_t index = best; index < mAmount; index++) {
+            mpTarget[index] = mpTarget[index + 1];
+            mQueuedAt[index] = mQueuedAt[index + 1];
+        }
+    }
+    return true;
+}
+
+uint16_t ReportQueue::getOldestAge() const
+{
+    return mAmount == 0 ? 0 : getAge(0);
+}
+
+uint16_t ReportQueue::getAge(uint8_t index) const
+{
+    time_t age = millis() - mQueuedAt[index];
+    return age > MAX_COUNT ? MAX_COUNT : age;
+}
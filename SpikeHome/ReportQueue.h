@@ -0,0 +1,91 @@
+/**
+ * ---------------------------------------------------------------------------------------------------
+ * This software is licensed under the GNU LESSER GENERAL PUBLIC LICENSE Version 3. It is furnished
+ * "as is", without any support, and with no warranty, express or implied, as to its usefulness for
+ * any purpose.
+ *
+ * File:      ReportQueue.h
+ * Purpose:   Queue of targets having a changed value to report to the server. The schedule sends the
+ *            pending reports before the periodic refresh (notifyServer). The report with the most
+ *            important priority class is sent first, reports of the same class in the order of their
+ *            arrival. A target is queued once, the report sends the value current at sending time.
+ *
+ * Author:    Volker Böhm
+ * Copyright: Volker Böhm
+ * Version:   1.0
+ * ---------------------------------------------------------------------------------------------------
+ */
+
+#ifndef __REPORTQUEUE_H
+#define __REPORTQUEUE_H
+
+#include "StdInclude.h"
+
+class ReportQueue {
+public:
+
+    static const uint8_t  SIZE      = 8;
+    static const uint16_t MAX_COUNT = 0xFFFF;
+
+    ReportQueue() : mAmount(0), mMaxAgeInMilliseconds(0), mSent(0), mRejected(0) {}
+
+    /**
+     * Adds a report to the queue. Nothing is changed, if the target already has a pending report.
+     * @param pTarget target with a changed value
+     * @return true, if the report is pending, false if the queue is full
+     */
+    bool add(NotifyTarget* pTarget);
+
+    /**
+     * Sends the most important pending report (see NotifyTarget::sendReport)
+     * @return true, if a report was pending
+     */
+    bool sendNext();
+
+    /**
+     * Gets the amount of pending reports
+     */
+    uint8_t getAmount() const { return mAmount; }
+
+    /**
+     * Gets the time the oldest pending report is waiting
+     * @return age in milliseconds (saturates at 65535), 0 if no report is pending
+     */
+    uint16_t getOldestAge() const;
+
+    /**
+     * Gets the longest time a report waited before it was sent
+     * @return age in milliseconds (saturates at 65535)
+     */
+    uint16_t getMaxAge() const { return mMaxAgeInMilliseconds; }
+
+    /**
+     * Gets the amount of reports sent
+     * @return amount of reports (saturates at 65535)
+     */
+    uint16_t getSent() const { return mSent; }
+
+    /**
+     * Gets the amount of reports rejected because the queue was full
+     * @return amount of reports (saturates at 65535)
+     */
+    uint16_t getRejected() const { return mRejected; }
+
+private:
+
+    /**
+     * Calculates the time a report is waiting
+     * @param index index of the report in the queue
+     * @return age in milliseconds (saturates at 65535)
+     */
+    uint16_t getAge(uint8_t index) const;
+
+    NotifyTarget* mpTarget[SIZE];
+    time_t        mQueuedAt[SIZE];
+    uint8_t       mAmount;
+    uint16_t      mMaxAgeInMilliseconds;
+    uint16_t      mSent;
+    uint16_t      mRejected;
+};
+
+#endif // __REPORTQUEUE_H
@@ -25,20 +25,36 @@ RollerShutter::RollerShutter(device_t deviceNo, pin_t powerPin, pin_t directionP
     mRollerTarget = 0;
     mInformServer = false;
     NotifyTarget::setCheckMask(NotifyTarget::CHECKSTATE_NORMAL);
+    NotifyTarget::unsubscribeAll();
+    NotifyTarget::subscribe(ROLLER_SHUTTER_KEY);
+    NotifyTarget::subscribe(ROLLER_TIME_KEY);
 }
 
 void RollerShutter::setMovement(movement_t movement)
 {
     mRollerMovement = movement;
     if (movement == MOVING_NOT) {
-         // Do not change the Direction pin here, because the power switch may be a little slower thus
-         // the roller will just move a short time in the opposit direction
-        digitalWrite(mPowerPin, LOW);
         mInformServer = true;
+    }
+    mRelayTask.restart();
+    switchRelays();
+}
+
+bool RollerShutter::switchRelays()
+{
+    TASK_BEGIN(mRelayTask);
+    digitalWrite(mPowerPin, LOW);
+    // Do not change the direction relay together with the power relay, because the power relay may be a
+    // little slower thus the roller would just move a short time in the opposite direction
+    TASK_WAIT_MS(mRelayTask, RELAY_SWITCH_TIME_IN_MILLISECONDS);
+    if (mRollerMovement == MOVING_NOT) {
+        digitalWrite(mDirectionPin, LOW);
     } else {
-        digitalWrite(mDirectionPin, movement == MOVING_UP ? HIGH : LOW);
+        digitalWrite(mDirectionPin, mRollerMovement == MOVING_UP ? HIGH : LOW);
+        TASK_WAIT_MS(mRelayTask, RELAY_SWITCH_TIME_IN_MILLISECONDS);
         digitalWrite(mPowerPin, HIGH);
     }
+    TASK_END(mRelayTask);
 }
 
 void RollerShutter::moveRoller(target_t target)
@@ -53,12 +69,13 @@ void RollerShutter::moveRoller(target_t target)
     mRollerTarget = target;
     if (mStatusUnknown) {
         movement = target == 100 ? MOVING_DOWN : MOVING_UP;
-        mRollerStatus = target == 100 ? 0 : 100;
+        mRollerStatus = target == 100 ? 0 : POSITION_CLOSED;
         mStatusUnknown = false;
     } else {
-        if (target == mRollerStatus) {
+        uint16_t targetPosition = target * POSITION_PER_PERCENT;
+        if (targetPosition == mRollerStatus) {
             movement = MOVING_NOT;
-        } else if (target > mRollerStatus) {
+        } else if (targetPosition > mRollerStatus) {
             movement = MOVING_DOWN;
         } else {
             movement = MOVING_UP;
@@ -69,7 +86,12 @@ void RollerShutter::moveRoller(target_t target)
 
 bool RollerShutter::notifyServer()
 {
-    return sendToServer(ROLLER_SHUTTER_KEY, target_t(mRollerStatus));
+    return sendToServer(ROLLER_SHUTTER_KEY, target_t(mRollerStatus / POSITION_PER_PERCENT));
+}
+
+bool RollerShutter::sendReport()
+{
+    return notifyServer();
 }
 
 void RollerShutter::handleChange(address_t senderAddress, key_t key, StateValue data)
@@ -87,26 +109,23 @@ void RollerShutter::handleChange(address_t senderAddress, key_t key, StateValue
 void RollerShutter::checkState(time_t scheduleLoops)
 {
     if (mInformServer) {
-        mInformServer = !notifyServer();
+        mInformServer = !requestReport();
     }
 
-    if (mRollerMovement == MOVING_NOT) {
-         // Disabling the direction relay on MOVING_NOT here ensures that it is done some time after
-         // the power relay has been disabled
-        if (digitalRead(mDirectionPin) == HIGH) {
-            digitalWrite(mDirectionPin, LOW);
-        }
-    } else {
+    // The roller does not move while the relays are switching
+    bool relaysSwitching = switchRelays();
+    if (!relaysSwitching && mRollerMovement != MOVING_NOT) {
 
-        float advanceInPercentPerTick = 100.0 * ACTIVITY_INTERVAL / MILLISECONDS_IN_A_SECOND / mRollerTime;
+        uint16_t advancePerTick = POSITION_CLOSED * ACTIVITY_INTERVAL / MILLISECONDS_IN_A_SECOND / mRollerTime;
+        uint16_t targetPosition = mRollerTarget * POSITION_PER_PERCENT;
         if (mRollerMovement == MOVING_UP) {
-            mRollerStatus = max(0, mRollerStatus - advanceInPercentPerTick);
-            if (mRollerStatus <= mRollerTarget) {
+            mRollerStatus = mRollerStatus > advancePerTick ? mRollerStatus - advancePerTick : 0;
+            if (mRollerStatus <= targetPosition) {
                 setMovement(MOVING_NOT);
             }
         } else if (mRollerMovement == MOVING_DOWN) {
-            mRollerStatus = min(100, mRollerStatus + advanceInPercentPerTick);
-            if (mRollerStatus >= mRollerTarget) {
+            mRollerStatus = POSITION_CLOSED - mRollerStatus > advancePerTick ? mRollerStatus + advancePerTick : POSITION_CLOSED;
+            if (mRollerStatus >= targetPosition) {
                 setMovement(MOVING_NOT);
             }
         }
@@ -19,16 +19,24 @@
 #define __ROLLERSHUTTER_H
 
 #include "StdInclude.h"
+#include "Task.h"
 
 class RollerShutter : public NotifyTarget {
 
 public:
 
     static const time_t ACTIVITY_INTERVAL           = MILLISECONDS_IN_A_SECOND / 10;
+    static const time_t RELAY_SWITCH_TIME_IN_MILLISECONDS = 100;
 
     typedef uint8_t movement_t;
     typedef uint8_t target_t;
 
+    /**
+     * The position is tracked in 1/256 percent, 0 = fully open
+     */
+    static const uint16_t POSITION_PER_PERCENT      = 256;
+    static const uint16_t POSITION_CLOSED           = 100 * POSITION_PER_PERCENT;
+
     /**
     * Creates a new RollerShutter class.
     * @param deviceNo, device to add the configuration values
@@ -49,6 +57,11 @@ public:
      **/
     virtual bool notifyServer();
 
+    /**
+     * Notifys server of the changed roller state (see requestReport)
+     **/
+    virtual bool sendReport();
+
 protected:
   /**
    * Sets the movement of the roller
@@ -56,6 +69,14 @@ protected:
    */
     void setMovement(movement_t movement);
 
+    /**
+     * Switches the relays to the current movement. The power relay is always switched off first, the
+     * direction relay is switched RELAY_SWITCH_TIME_IN_MILLISECONDS later and the power relay is switched
+     * on again after another RELAY_SWITCH_TIME_IN_MILLISECONDS.
+     * @return true, while the relays are switching
+     */
+    bool switchRelays();
+
     /**
      * Moves the roller to a target state in percent;
      * 0 = fully open
@@ -75,12 +96,13 @@ protected:
     pin_t       mPowerPin;
     pin_t       mDirectionPin;
     uint8_t     mRollerTime;
-    float       mRollerStatus;
+    uint16_t    mRollerStatus;
     movement_t  mRollerMovement;
     device_t    mDeviceNo;
     target_t    mRollerTarget;
     bool        mStatusUnknown;
     bool        mInformServer;
+    Task        mRelayTask;
 
 };
 
@@ -13,21 +13,45 @@
  */
 #include "Schedule.h"
 #include "Device.h"
+#include "Memory.h"
+#include "PinEvents.h"
+#include "DigitalInputs.h"
+#include <avr/sleep.h>
 
 time_t              Schedule::mLoops;
+uint16_t            Schedule::mNextCheck;
+uint32_t            Schedule::mTickStartInMicroseconds;
+uint16_t            Schedule::mDeferredInTick;
+uint16_t            Schedule::mDeferredCalls;
+uint16_t            Schedule::mDeferringTicks;
+bool                Schedule::mBalanced;
+value_t             Schedule::mWorstLoadBeforeBalancing;
+value_t             Schedule::mWorstLoadAfterBalancing;
 NotifyTargetList    Schedule::mTargetList;
 NotifyTarget*       Schedule::mNotifyIterator;
 time_t              Schedule::mNotifyTimer;
 uint16_t            Schedule::mNotifyLoopCount;
 value_t             Schedule::mConfigInfoPeriod;
+TickHistogram       Schedule::mLagHistogram;
+TickHistogram       Schedule::mOverrunHistogram;
+ReportQueue         Schedule::mReportQueue;
+EventQueue          Schedule::mEventQueue;
+value_t             Schedule::mEventBudget;
 
 void Schedule::init()
 {
     mLoops = 0;
+    mNextCheck = 0;
+    mDeferredCalls = 0;
+    mDeferringTicks = 0;
+    mBalanced = false;
+    mWorstLoadBeforeBalancing = 0;
+    mWorstLoadAfterBalancing = 0;
     mNotifyLoopCount = 0;
     mNotifyTimer = 0;
     mNotifyIterator = 0;
     mConfigInfoPeriod = Device::addConfigValue(0, NotifyTarget::CONFIG_INFO_PERIOD_KEY, 2);
+    mEventBudget = Device::addConfigValue(0, NotifyTarget::EVENT_BUDGET_KEY, DEFAULT_EVENT_BUDGET);
 }
 
 void softwareReset()
@@ -40,28 +64,47 @@ void Schedule::nextTick()
 #ifdef DEBUG
     checkSettings();
 #endif
-    time_t nextDelay;
     time_t curTimeInMilliseconds = millis();
+    mTickStartInMicroseconds = micros();
+    mDeferredInTick = 0;
     time_t targetTimeInMilliseconds = mLoops * NotifyTarget::MILLISECONDS_PER_LOOP;
     mLoops++;
-    // Respects millis overflow a-b works well for unsigned variables even when a overflows.
-    nextDelay = timeDiff(targetTimeInMilliseconds, curTimeInMilliseconds);
+    // The tick was planned to start one loop before its target time
+    int32_t lag = curTimeInMilliseconds - (targetTimeInMilliseconds - NotifyTarget::MILLISECONDS_PER_LOOP);
+    if (mLoops > 1) {
+        mLagHistogram.add(lag > 0 ? lag : 0);
+    }
     Device::getIOHandler()->pollNonBlocking();
-    notify();
+    DigitalInputs::sample();
+    PinEvents::dispatch();
     checkState();
-#ifdef DEBUG
-    static time_t oldLag = 0;
-    if (nextDelay == 0) {
-        time_t lag = curTimeInMilliseconds - targetTimeInMilliseconds + 10;
-        if (oldLag < lag) {
-            oldLag = lag;
-            printIfDebug(F("lag: ")); printlnIfDebug(curTimeInMilliseconds - targetTimeInMilliseconds + 10);
+    deliverChanges();
+    notify();
+    countDeferred();
+    time_t tickDuration = millis() - curTimeInMilliseconds;
+    if (tickDuration > NotifyTarget::MILLISECONDS_PER_LOOP) {
+        mOverrunHistogram.add(tickDuration - NotifyTarget::MILLISECONDS_PER_LOOP);
+    }
+    idleUntil(targetTimeInMilliseconds);
+}
+
+void Schedule::countDeferred()
+{
+    if (mDeferredInTick > 0) {
+        mDeferredCalls = min(uint32_t(mDeferredCalls) + mDeferredInTick, uint32_t(MAX_COUNT));
+        if (mDeferringTicks < MAX_COUNT) {
+            mDeferringTicks++;
         }
-    } else {
-        oldLag = 0;
     }
-#endif
-    delay(nextDelay);
+}
+
+void Schedule::idleUntil(time_t timeInMilliseconds)
+{
+    set_sleep_mode(SLEEP_MODE_IDLE);
+    // Respects millis overflow a-b works well for unsigned variables even when a overflows.
+    while (int32_t(millis() - timeInMilliseconds) < 0) {
+        sleep_mode();
+    }
 }
 
 void Schedule::addTarget(NotifyTarget* pTarget)
@@ -69,6 +112,22 @@ void Schedule::addTarget(NotifyTarget* pTarget)
     mTargetList.add(pTarget);
 }
 
+bool Schedule::startProfiling()
+{
+    bool allProfiled = true;
+    for (NotifyTarget* cur = mTargetList.getFirstNotifyTarget(); cur != 0; cur = cur->getNext()) {
+        if (cur->getProfile() != 0) {
+            continue;
+        }
+        if (Trace::getFreeMemory() < sizeof(TargetProfile) + PROFILE_MEMORY_RESERVE) {
+            allProfiled = false;
+            break;
+        }
+        cur->setProfile(new TargetProfile());
+    }
+    return allProfiled;
+}
+
 void Schedule::notifyChange(device_t deviceNo, address_t senderAddress, key_t key, value_t value)
 {
     if (key == NotifyTarget::CONFIG_INFO_PERIOD_KEY && senderAddress == SerialIO::SERVER_ADDRESS) {
@@ -76,6 +135,11 @@ void Schedule::notifyChange(device_t deviceNo, address_t senderAddress, key_t ke
             mConfigInfoPeriod = value;
             Device::setConfigValue(0, key, value);
         }
+    } else if (key == NotifyTarget::EVENT_BUDGET_KEY && senderAddress == SerialIO::SERVER_ADDRESS) {
+        if  (value > 0 && deviceNo == 0 ) {
+            mEventBudget = value;
+            Device::setConfigValue(0, key, value);
+        }
     } else {
         mTargetList.notifyChange(deviceNo, senderAddress, key, value);
     }
@@ -88,34 +152,164 @@ void Schedule::broadcastChange(address_t senderAddress, key_t key, value_t value
             mConfigInfoPeriod = value;
             Device::setConfigValue(0, key, value);
         }
+    } else if (key == NotifyTarget::EVENT_BUDGET_KEY) {
+        if  (value > 0) {
+            mEventBudget = value;
+            Device::setConfigValue(0, key, value);
+        }
     } else {
-        for (device_t deviceNo = 0; deviceNo < Device::getDeviceAmount(); deviceNo++) {
-            mTargetList.notifyChange(deviceNo, senderAddress, key, value);
+        mTargetList.notifyAllDevices(Device::getDeviceAmount(), senderAddress, key, value);
+    }
+}
+
+void Schedule::deliverChanges()
+{
+    EventQueue::Event event;
+    for (value_t delivered = 0; delivered < mEventBudget && mEventQueue.remove(event); delivered++) {
+        if (event.deviceNo == EventQueue::ALL_DEVICES) {
+            broadcastChange(0, event.key, event.value.toInt());
+        } else {
+            Device::getNotify(event.deviceNo).change(event.key, event.value);
         }
     }
 }
 
 void Schedule::notify()
+{
+    if (Device::getIOHandler()->maySend() && !mReportQueue.sendNext()) {
+        refresh();
+    }
+}
+
+void Schedule::refresh()
 {
     bool enoughTimeElapsed = millis() - mNotifyTimer > mConfigInfoPeriod * NotifyTarget::MILLISECONDS_IN_A_SECOND;
 
-    if (Device::getIOHandler()->maySend() && enoughTimeElapsed && mTargetList.getFirstNotifyTarget() != 0)  {
-        mNotifyTimer = millis();
+    if (enoughTimeElapsed && mTargetList.getFirstNotifyTarget() != 0)  {
         if (mNotifyIterator == 0) {
             mNotifyIterator = mTargetList.getFirstNotifyTarget();
         }
-        if (mNotifyIterator->notifyServer(mNotifyLoopCount)) {
-            mNotifyLoopCount = 0;
-            mNotifyIterator = mNotifyIterator->getNext();
+        // Background targets may be deferred up to one second
+        bool overdue = millis() - mNotifyTimer > (mConfigInfoPeriod + 1) * NotifyTarget::MILLISECONDS_IN_A_SECOND;
+        bool background = mNotifyIterator->getPriority() == NotifyTarget::PRIORITY_BACKGROUND;
+        if (background && !overdue && isOverBudget()) {
+            mDeferredInTick++;
         } else {
-            mNotifyLoopCount ++;
+            mNotifyTimer = millis();
+            if (mNotifyIterator->callNotifyServer(mNotifyLoopCount)) {
+                mNotifyLoopCount = 0;
+                mNotifyIterator = mNotifyIterator->getNext();
+            } else {
+                mNotifyLoopCount ++;
+            }
         }
     }
 }
 
 void Schedule::checkState()
 {
-    mTargetList.callCheckState(mLoops);
+    if (!mBalanced && mLoops >= BALANCE_AFTER_LOOPS) {
+        balancePhases();
+    }
+    if (int16_t(uint16_t(mLoops) - mNextCheck) >= 0) {
+        mNextCheck = mLoops + MAX_LOOPS_WITHOUT_CHECK;
+        requestCheck(mTargetList.callCheckState(mLoops, mNextCheck, mTickStartInMicroseconds, mDeferredInTick));
+    }
+}
+
+void Schedule::balancePhases()
+{
+    value_t load[LOAD_SLOTS];
+    getLoadProfile(load);
+    mWorstLoadBeforeBalancing = getWorstLoad(load);
+    for (uint8_t slot = 0; slot < LOAD_SLOTS; slot++) {
+        load[slot] = 0;
+    }
+
+    // Selects the targets ordered by cost (descending) and position in the list
+    value_t lastCost = 0xFFFF;
+    list_t lastIndex = 0;
+    while (true) {
+        NotifyTarget* best = 0;
+        value_t bestCost = 0;
+        list_t bestIndex = 0;
+        list_t index = 0;
+        for (NotifyTarget* cur = mTargetList.getFirstNotifyTarget(); cur != 0; cur = cur->getNext(), index++) {
+            value_t cost = cur->getCost();
+            bool afterLast = cost < lastCost || (cost == lastCost && index > lastIndex);
+            if (cur->getCheckMask() != NotifyTarget::CHECKSTATE_NEVER && afterLast && (best == 0 || cost > bestCost)) {
+                best = cur;
+                bestCost = cost;
+                bestIndex = index;
+            }
+        }
+        if (best == 0) {
+            break;
+        }
+        assignPhase(best, load);
+        lastCost = bestCost;
+        lastIndex = bestIndex;
+    }
+    mWorstLoadAfterBalancing = getWorstLoad(load);
+    mBalanced = true;
+}
+
+void Schedule::assignPhase(NotifyTarget* pTarget, value_t load[])
+{
+    uint8_t step = getLoadStep(pTarget);
+    uint8_t bestPhase = 0;
+    value_t bestLoad = 0xFFFF;
+    for (uint8_t phase = 0; phase < step; phase++) {
+        value_t worstLoad = 0;
+        for (uint8_t slot = phase; slot < LOAD_SLOTS; slot += step) {
+            worstLoad = max(worstLoad, load[slot]);
+        }
+        if (worstLoad < bestLoad) {
+            bestLoad = worstLoad;
+            bestPhase = phase;
+        }
+    }
+    addLoad(load, bestPhase, step, pTarget->getCost());
+    // The next loop after the current one in the chosen slot, later periodic calls are kept in the slot
+    pTarget->setPhase(bestPhase);
+    pTarget->setNextCheck(alignToPhase(pTarget, mLoops + 1));
+    requestCheck(pTarget->getNextCheck());
+}
+
+void Schedule::getLoadProfile(value_t load[])
+{
+    for (uint8_t slot = 0; slot < LOAD_SLOTS; slot++) {
+        load[slot] = 0;
+    }
+    for (NotifyTarget* cur = mTargetList.getFirstNotifyTarget(); cur != 0; cur = cur->getNext()) {
+        if (cur->getCheckMask() != NotifyTarget::CHECKSTATE_NEVER) {
+            uint8_t step = getLoadStep(cur);
+            uint16_t phase = cur->getPhase() != NotifyTarget::NO_PHASE ? cur->getPhase() : cur->getNextCheck();
+            addLoad(load, phase % step, step, cur->getCost());
+        }
+    }
+}
+
+void Schedule::addLoad(value_t load[], uint8_t phase, uint8_t step, value_t cost)
+{
+    for (uint8_t slot = phase; slot < LOAD_SLOTS; slot += step) {
+        load[slot] = min(uint32_t(load[slot]) + cost, uint32_t(0xFFFF));
+    }
+}
+
+uint8_t Schedule::getLoadStep(NotifyTarget* pTarget)
+{
+    uint16_t period = uint16_t(pTarget->getCheckMask()) + 1;
+    return period < LOAD_SLOTS ? period : LOAD_SLOTS;
+}
+
+value_t Schedule::getWorstLoad(value_t load[])
+{
+    value_t worstLoad = 0;
+    for (uint8_t slot = 0; slot < LOAD_SLOTS; slot++) {
+        worstLoad = max(worstLoad, load[slot]);
+    }
+    return worstLoad;
 }
 
 void Schedule::checkSettings()
@@ -129,14 +323,21 @@ void Schedule::checkSettings()
 
     printlnIfDebug(F("Checking settings...."));
     printIfDebug(F("Memory left (space between heap and stack) in Bytes: ")); printlnIfDebug(Trace::getFreeMemory());
+    printIfDebug(F("Stack never used since reboot in Bytes: ")); printlnIfDebug(Memory::getUnusedStack());
+    printIfDebug(F("Heap free list (holes) in Bytes: ")); printlnIfDebug(Memory::getFreeListSize());
     printIfDebug(F("Amount of Devices: ")); printlnIfDebug(Device::getDeviceAmount());
     printlnIfDebug(F("Starting 1000 checkState loop to test timings..."));
     time_t start = millis();
     for (mLoops = 0; mLoops < 1000; mLoops++) {
+        mNextCheck = mLoops;
         checkState();
+        deliverChanges();
     }
     mLoops = 0;
-    printIfDebug(F("Time used per loop (must be << 10) : ")); printlnIfDebug((millis() - start) / 1000.0);
+    mNextCheck = 0;
+    mTargetList.restartChecks(mLoops);
+    // 1000 loops, thus milliseconds of all loops are microseconds per loop
+    printIfDebug(F("Time used per loop in microseconds (must be << 10000) : ")); printlnIfDebug(millis() - start);
     printIfDebug(F(""));
     for (device_t deviceNo = 0; deviceNo < Device::getDeviceAmount(); deviceNo++) {
         printIfDebug(F("Listeners per device: ")); printIfDebug(Device::getNotify(deviceNo).getListenerAmount());
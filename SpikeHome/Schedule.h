@@ -12,6 +12,19 @@
  *            be used to send the current state of the object to the server (via. RS485 Bus).
  *            One object after another receives this event and the interval between two objects
  *            receiving the event can be configured in 1 seconds steps.
+ *            Changed values are reported earlier: targets request a report (NotifyTarget::requestReport)
+ *            and pending reports are sent first, the periodic notifyServer only uses ticks without
+ *            pending report.
+ *            Changes notified by targets (NotifyTarget::notify, notifyAllDevices) are queued and
+ *            delivered after the checkState calls, at most getEventBudget() changes per tick.
+ *            Every target declares the loop its checkState is due next. Only due targets are called
+ *            and the CPU sleeps (idle mode, interrupts stay active) until the next 10 ms tick.
+ *            Targets are called in the order of their priority. Background targets are deferred to the
+ *            next tick, if the tick budget is used up (see NotifyTarget::PRIORITY_BACKGROUND).
+ *            The costs of the checkState calls are measured for BALANCE_AFTER_LOOPS loops after
+ *            reboot. Then the phases of the targets are balanced to spread the work evenly over the
+ *            ticks. Every target keeps its phase: the periodic call following a deadline (checkAgainIn)
+ *            or a deferred call is moved back to the assigned phase.
  * Author:    Volker Böhm
  * Copyright: Volker Böhm
  * Version:   1.0
@@ -23,6 +36,9 @@
 
 #include "StdInclude.h"
 #include "NotifyTargetList.h"
+#include "Profile.h"
+#include "ReportQueue.h"
+#include "EventQueue.h"
 
 typedef uint8_t timer_t;
 
@@ -55,19 +71,211 @@ public:
 
     /**
      * Main schedule function. Needs to be added to the main loop. Handles all scheduling and ensures that
-     * 10 milliseconds are passed between two ticks by calling the necessary delay. (Example if objects took 7
-     * milliseconds to handle their work the delay will last 3 milliseconds).
-     * Even if on tick lasts longer than 10 milliseconds the function tries to reach 10 seconds in average by
-     * reducing the time of the next ticks.
+     * 10 milliseconds are passed between two ticks by sleeping until the next tick is due. (Example if objects
+     * took 7 milliseconds to handle their work the CPU will sleep 3 milliseconds).
+     * Even if on tick lasts longer than 10 milliseconds the function tries to reach 10 milliseconds in average by
+     * skipping the sleep of the next ticks.
+     * The bus is polled every tick, checkState is only called for targets being due.
      */
     static void nextTick();
 
+    /**
+     * Gets the amount of loops (ticks) since reboot
+     * @return number of the current loop
+     */
+    static time_t getLoops()
+    {
+        return mLoops;
+    }
+
+    /**
+     * Requests a checkState walk in a loop. Used by NotifyTarget::checkAgainIn
+     * @param loop loop the walk is requested for (lower 16 bits of the loop count)
+     */
+    static void requestCheck(uint16_t loop)
+    {
+        if (int16_t(loop - mNextCheck) < 0) {
+            mNextCheck = loop;
+        }
+    }
+
     /**
      * Adds a target to check regularily by calling his checkState method
      * @param pTarget pointer to a notification Target
      */
     static void addTarget(NotifyTarget* pTarget);
 
+    /**
+     * Gets a registered target by its position in the schedule list
+     * @param index position in the list
+     * @return target or 0, if index is out of range
+     */
+    static NotifyTarget* getTarget(list_t index)
+    {
+        return mTargetList.getTarget(index);
+    }
+
+    /**
+     * Starts measuring the execution time of checkState, handleChange and notifyServer for every registered
+     * target. The statistics are allocated on the heap on the first call. Targets are skipped if the memory
+     * left would drop below PROFILE_MEMORY_RESERVE.
+     * @return true, if all targets are profiled
+     */
+    static bool startProfiling();
+
+    /**
+     * Gets the histogram of the tick lag. The lag is the time a tick starts later than planned.
+     * @return lag histogram in milliseconds
+     */
+    static const TickHistogram& getLagHistogram()
+    {
+        return mLagHistogram;
+    }
+
+    /**
+     * Gets the histogram of tick overruns. Only ticks lasting longer than MILLISECONDS_PER_LOOP are counted
+     * with the time exceeding the tick period.
+     * @return overrun histogram in milliseconds
+     */
+    static const TickHistogram& getOverrunHistogram()
+    {
+        return mOverrunHistogram;
+    }
+
+    /**
+     * Gets the amount of checkState and notifyServer calls of background targets deferred to a later tick
+     * @return amount of deferred calls (saturates at 65535)
+     */
+    static uint16_t getDeferredCalls()
+    {
+        return mDeferredCalls;
+    }
+
+    /**
+     * Gets the amount of ticks that deferred background calls, because the tick budget was used up
+     * @return amount of ticks (saturates at 65535)
+     */
+    static uint16_t getDeferringTicks()
+    {
+        return mDeferringTicks;
+    }
+
+    /**
+     * Moves a periodic checkState call to the next loop in the phase of a target assigned by balancing
+     * @param pTarget target having a phase
+     * @param loop loop of the periodic call (lower 16 bits of the loop count)
+     * @return same or next loop in the phase of the target
+     */
+    static uint16_t alignToPhase(NotifyTarget* pTarget, uint16_t loop)
+    {
+        uint8_t step = getLoadStep(pTarget);
+        return loop + (pTarget->getPhase() + step - loop % step) % step;
+    }
+
+    /**
+     * Checks, if the schedule measures the costs of the checkState calls for phase balancing
+     * @return true, if the phases are not yet balanced
+     */
+    static bool isMeasuringCost()
+    {
+        return !mBalanced;
+    }
+
+    /**
+     * Calculates the expected checkState load of the next LOAD_SLOTS ticks from the costs and phases of all targets.
+     * Targets checked less often than every LOAD_SLOTS ticks are counted like targets checked every LOAD_SLOTS ticks
+     * (worst case).
+     * @param load output: load of every slot in microseconds
+     */
+    static void getLoadProfile(value_t load[]);
+
+    /**
+     * Gets the load of the slot with the highest load before balancing
+     * @return load in microseconds
+     */
+    static value_t getWorstLoadBeforeBalancing()
+    {
+        return mWorstLoadBeforeBalancing;
+    }
+
+    /**
+     * Gets the load of the slot with the highest load after balancing
+     * @return load in microseconds
+     */
+    static value_t getWorstLoadAfterBalancing()
+    {
+        return mWorstLoadAfterBalancing;
+    }
+
+    /**
+     * Gets the amount of handleChange calls of changes received or broadcasted
+     * @return amount of calls (saturates at 65535)
+     */
+    static uint16_t getHandleChangeCalls()
+    {
+        return mTargetList.getHandleChangeCalls();
+    }
+
+    /**
+     * Gets the amount of handleChange calls saved by key subscriptions (see NotifyTarget::subscribe)
+     * @return amount of calls (saturates at 65535)
+     */
+    static uint16_t getHandleChangeSkips()
+    {
+        return mTargetList.getHandleChangeSkips();
+    }
+
+    /**
+     * Queues a report of a changed value (see NotifyTarget::requestReport)
+     * @param pTarget target with a changed value
+     * @return true, if the report is pending, false if the queue is full
+     */
+    static bool requestReport(NotifyTarget* pTarget)
+    {
+        return mReportQueue.add(pTarget);
+    }
+
+    /**
+     * Gets the queue of pending reports, used to report its statistics
+     */
+    static const ReportQueue& getReportQueue()
+    {
+        return mReportQueue;
+    }
+
+    /**
+     * Queues a change for delivery to the targets of a device (see NotifyTarget::notify)
+     * @param deviceNo number of the device, EventQueue::ALL_DEVICES for all devices
+     * @param key key/identifier of the change
+     * @param value new value
+     */
+    static void postChange(device_t deviceNo, key_t key, StateValue value)
+    {
+        mEventQueue.add(deviceNo, key, value);
+    }
+
+    /**
+     * Gets the queue of changes, used to report its statistics
+     */
+    static const EventQueue& getEventQueue()
+    {
+        return mEventQueue;
+    }
+
+    /**
+     * Gets the maximal amount of changes delivered per tick
+     * @return amount of changes (see NotifyTarget::EVENT_BUDGET_KEY)
+     */
+    static value_t getEventBudget()
+    {
+        return mEventBudget;
+    }
+
+    /**
+     * Amount of ticks in the load profile, equals the period of CHECKSTATE_NORMAL
+     */
+    static const uint8_t LOAD_SLOTS = NotifyTarget::CHECKSTATE_NORMAL + 1;
+
     /**
      * Notifies all objects/sensors of a device of a configuration change
      * @param deviceNo number of device
@@ -88,24 +296,79 @@ public:
 private:
 
     /**
-     * regularily calls notify functions of registered objects if enough time is elapsed
+     * Sends the most important pending report. Without pending report it calls the notify functions of
+     * the registered objects, if enough time is elapsed
      */
     static void notify();
 
     /**
-     * Calculates the difference of two times for unsigned numbers. Ensures that the result is not below zero
-     * @param start time to subtract from
-     * @param sub time to subtract
-     * @return 0 if sub >= time, time - sub else
+     * regularily calls notify functions of registered objects if enough time is elapsed
      */
-    static time_t timeDiff(time_t start, time_t sub) {
-        time_t result = start > sub ? start - sub : 0;
-        if (result > NotifyTarget::MILLISECONDS_PER_LOOP) {
-            result = NotifyTarget::MILLISECONDS_PER_LOOP;
-        }
-        return result;
+    static void refresh();
+
+    /**
+     * Delivers queued changes to the targets, at most mEventBudget changes. Changes posted while
+     * delivering are queued and delivered later in this or the next tick.
+     */
+    static void deliverChanges();
+
+    /**
+     * Puts the CPU to idle sleep until a time is reached. Interrupts (timer, serial, pin change) are still
+     * handled, the CPU sleeps again after handling them until the time is reached.
+     * @param timeInMilliseconds time to wake up (compared to millis())
+     */
+    static void idleUntil(time_t timeInMilliseconds);
+
+    /**
+     * Checks, if the current tick used up its time budget
+     * @return true, if background calls should be deferred
+     */
+    static bool isOverBudget()
+    {
+        return micros() - mTickStartInMicroseconds > NotifyTarget::TICK_BUDGET_IN_MICROSECONDS;
     }
 
+    /**
+     * Adds the calls deferred in the current tick to the statistics
+     */
+    static void countDeferred();
+
+    /**
+     * Assigns the phases (loop of the next check) of all targets with a greedy algorithm: the most expensive
+     * target not yet assigned is placed in the phase where the highest load of its slots is lowest.
+     */
+    static void balancePhases();
+
+    /**
+     * Chooses the phase of a target with the lowest maximal load and adds its cost to the load profile
+     * @param pTarget target to assign a phase to
+     * @param load load profile of the targets already assigned
+     */
+    static void assignPhase(NotifyTarget* pTarget, value_t load[]);
+
+    /**
+     * Adds the cost of a target to the slots of a phase
+     * @param load load profile
+     * @param phase first slot of the target
+     * @param step distance between two slots of the target
+     * @param cost cost to add in microseconds
+     */
+    static void addLoad(value_t load[], uint8_t phase, uint8_t step, value_t cost);
+
+    /**
+     * Gets the distance between two load slots of a target
+     * @param pTarget target
+     * @return period of the target, but at most LOAD_SLOTS
+     */
+    static uint8_t getLoadStep(NotifyTarget* pTarget);
+
+    /**
+     * Gets the highest load of a load profile
+     * @param load load profile
+     * @return highest load in microseconds
+     */
+    static value_t getWorstLoad(value_t load[]);
+
     /**
      * Regularily calls checkState for registered objects
      */
@@ -118,15 +381,35 @@ private:
 
 
     static const time_t NOTIFY_INTERVAL_IN_MILLISECONDS = ONE_SECOND * 1;
+    static const uint16_t PROFILE_MEMORY_RESERVE        = 300;
+    /**
+     * Maximal amount of loops between two checkState walks, if no target is due
+     */
+    static const uint16_t MAX_LOOPS_WITHOUT_CHECK       = 0x100;
+    static const uint16_t MAX_COUNT                     = 0xFFFF;
+    static const time_t   BALANCE_AFTER_LOOPS           = 5 * NotifyTarget::LOOPS_PER_SECOND;
+    static const value_t  DEFAULT_EVENT_BUDGET          = 8;
 
 
-    static time_t         mNextLoop;
     static time_t         mLoops;
+    static uint16_t       mNextCheck;
+    static uint32_t       mTickStartInMicroseconds;
+    static uint16_t       mDeferredInTick;
+    static uint16_t       mDeferredCalls;
+    static uint16_t       mDeferringTicks;
+    static bool           mBalanced;
+    static value_t        mWorstLoadBeforeBalancing;
+    static value_t        mWorstLoadAfterBalancing;
     static NotifyTargetList mTargetList;
     static time_t         mNotifyTimer;
     static NotifyTarget*  mNotifyIterator;
     static uint16_t       mNotifyLoopCount;
     static value_t        mConfigInfoPeriod;
+    static TickHistogram  mLagHistogram;
+    static TickHistogram  mOverrunHistogram;
+    static ReportQueue    mReportQueue;
+    static EventQueue     mEventQueue;
+    static value_t        mEventBudget;
 
 };
 
@@ -0,0 +1,214 @@
+/**
+ * ---------------------------------------------------------------------------------------------------
+ * This software is licensed under the GNU LESSER GENERAL PUBLIC LICENSE Version 3. It is furnished
+ * "as is", without any support, and with no warranty, express or implied, as to its usefulness for
+ * any purpose.
+ *
+ * File:      SensorT.h
+ * Purpose:   Sensor composed of policies at compile time. A sensor reads a raw value (Reader), smoothes
+ *            it (Filter), decides if it changed enough (ChangePolicy) and notifies the change (Reporter).
+ *            The policies are called inline by checkState, the only virtual call per sample is checkState
+ *            itself. A new sensor is a typedef or a small subclass, for example:
+ *
+ *            typedef SensorT<AnalogPinReader, AverageFilter<4>, DeadbandChange<8> > PotiSensor;
+ *            new PotiSensor(deviceNo, 'p', AnalogPinReader(A1, NotifyTarget::NOT_INVERTED));
+ *
+ *            Policy interface:
+ *            Reader:       value_t read(uint8_t capturedLevel), capturedLevel is the level of the last
+ *                          captured edge or State::LEVEL_NOT_CAPTURED (see State::captureEdges)
+ *            Filter:       value_t filter(value_t rawValue, value_t lastValue)
+ *            ChangePolicy: bool hasChanged(value_t curValue, value_t lastValue), the change must
+ *                          additionally exceed the deadband of the report policy configured at runtime
+ *                          (see State::setReportPolicy)
+ *            Reporter:     NOTIFY_DEVICE (notify targets of the device), REPORT_SERVER (queue a report)
+ *
+ * Author:    Volker Böhm
+ * Copyright: Volker Böhm
+ * Version:   1.0
+ * ---------------------------------------------------------------------------------------------------
+ */
+
+#ifndef __SENSORT_H
+#define __SENSORT_H
+
+#include "StdInclude.h"
+#include "State.h"
+
+/**
+ * Reads a digital or analog pin as binary value (see State::digitalReadState)
+ */
+class DigitalPinReader {
+public:
+    DigitalPinReader(pin_t pin, bool invert) : mPin(pin), mInvert(invert) {}
+
+    value_t read(uint8_t capturedLevel) const
+    {
+        if (capturedLevel == State::LEVEL_NOT_CAPTURED) {
+            return State::digitalReadState(mPin, mInvert);
+        }
+        return (capturedLevel == HIGH) != mInvert ? HIGH : LOW;
+    }
+
+    pin_t mPin;
+    bool  mInvert;
+};
+
+/**
+ * Reads an analog pin (see State::analogReadState)
+ */
+class AnalogPinReader {
+public:
+    AnalogPinReader(pin_t pin, bool inverted) : mPin(pin), mInverted(inverted) {}
+
+    value_t read(uint8_t capturedLevel) const
+    {
+        return State::analogReadState(mPin, mInverted);
+    }
+
+    pin_t mPin;
+    bool  mInverted;
+};
+
+/**
+ * Uses the raw value unchanged
+ */
+class NoFilter {
+public:
+    value_t filter(value_t rawValue, value_t lastValue) const
+    {
+        return rawValue;
+    }
+};
+
+/**
+ * Moving average, the new value has a weight of 1 / WEIGHT
+ */
+template <uint8_t WEIGHT>
+class AverageFilter {
+public:
+    value_t filter(value_t rawValue, value_t lastValue) const
+    {
+        return value_t((uint32_t(lastValue) * (WEIGHT - 1) + rawValue) / WEIGHT);
+    }
+};
+
+/**
+ * Any difference is a change
+ */
+class AnyChange {
+public:
+    bool hasChanged(value_t curValue, value_t lastValue) const
+    {
+        return curValue != lastValue;
+    }
+};
+
+/**
+ * A change must be larger than ABSOLUTE and at least RELATIVE_PERCENT percent of the current value
+ */
+template <value_t ABSOLUTE, uint8_t RELATIVE_PERCENT = 0>
+class DeadbandChange {
+public:
+    bool hasChanged(value_t curValue, value_t lastValue) const
+    {
+        value_t difference = curValue > lastValue ? curValue - lastValue : lastValue - curValue;
+        return difference > ABSOLUTE &&
+            uint32_t(difference) * 100 >= uint32_t(curValue) * RELATIVE_PERCENT;
+    }
+};
+
+/**
+ * Notifies the targets of the device and reports the change to the server
+ */
+class NotifyAndReport {
+public:
+    static const bool NOTIFY_DEVICE = true;
+    static const bool REPORT_SERVER = true;
+};
+
+/**
+ * Reports the change to the server only, the periodic refresh is not affected
+ */
+class ReportOnly {
+public:
+    static const bool NOTIFY_DEVICE = false;
+    static const bool REPORT_SERVER = true;
+};
+
+template <class READER, class FILTER, class CHANGE_POLICY, class REPORTER = NotifyAndReport>
+class SensorT : public State {
+public:
+
+    /**
+     * Constructs a sensor
+     * @param deviceNo number of the device the object belongs to
+     * @param notifyKey identifier to send notifications
+     * @param reader reader policy, holding the pin
+     * @param filter filter policy
+     * @param changePolicy change policy
+     */
+    SensorT(device_t deviceNo, key_t notifyKey, const READER& reader,
+        const FILTER& filter = FILTER(), const CHANGE_POLICY& changePolicy = CHANGE_POLICY())
+    : State(deviceNo, notifyKey), mReader(reader), mFilter(filter), mChangePolicy(changePolicy) {}
+
+    /**
+     * Reads, filters and checks the value and notifies changes (see State::checkState)
+     * @param scheduleLoops number of checkState loops since reboot
+     */
+    virtual void checkState(time_t scheduleLoops)
+    {
+        value_t curValue = readValue();
+        if (isReportable(curValue, mLastValue.toInt())) {
+            if (REPORTER::NOTIFY_DEVICE && mNotifyKey != 0) {
+                notify(mNotifyKey, StateValue(curValue));
+            }
+            storeChange(StateValue(curValue));
+            mNotifyServer = REPORTER::REPORT_SERVER;
+        }
+        reportIfDue(StateValue(curValue), scheduleLoops);
+    }
+
+protected:
+
+    /**
+     * Reads and filters the current value
+     * @return filtered value
+     */
+    value_t readValue()
+    {
+        return mFilter.filter(mReader.read(mCapturedLevel), mLastValue.toInt());
+    }
+
+    /*
+     * Reads the current value, used by the periodic refresh (see State::notifyServer)
+     */
+    virtual StateValue getValue()
+    {
+        return StateValue(readValue());
+    }
+
+    /**
+     * Checks, if a change passes the change policy and the deadband of the report policy
+     * @param curValue current value
+     * @param lastValue last value
+     * @return true, if the change is notified
+     */
+    bool isReportable(value_t curValue, value_t lastValue)
+    {
+        return mChangePolicy.hasChanged(curValue, lastValue) && mReportPolicy.exceedsDeadband(curValue, lastValue);
+    }
+
+    /**
+     * Checks if the state has changed, using the change policy
+     */
+    virtual bool hasChanged(StateValue curValue, StateValue lastValue)
+    {
+        return isReportable(curValue.toInt(), lastValue.toInt());
+    }
+
+    READER        mReader;
+    FILTER        mFilter;
+    CHANGE_POLICY mChangePolicy;
+};
+
+#endif // __SENSORT_H
@@ -97,6 +97,15 @@ public:
         return true;
     }
 
+    /**
+     * Checks if the connection to the server is established. Changes are stored while it is not
+     * (see History.h). It is always true for the standard serial interface.
+     */
+    virtual bool isConnected()
+    {
+        return true;
+    }
+
 protected:
 
     /**
@@ -0,0 +1,109 @@
+/**
+ * ---------------------------------------------------------------------------------------------------
+ * This software is licensed under the GNU LESSER GENERAL PUBLIC LICENSE Version 3. It is furnished
+ * "as is", without any support, and with no warranty, express or implied, as to its usefulness for
+ * any purpose.
+ *
+ * File:      SettleDetector.h
+ * Purpose:   Detects when an analog value has settled after a change, for example the brightness after
+ *            setting a new light level. The samples are collected in windows of WINDOW_SAMPLES, the value
+ *            is settled as soon as the variance of a window is at most the threshold. The detection gives
+ *            up after a maximal amount of windows, thus the wait is bounded. The result is the mean of the
+ *            last window.
+ *
+ * Author:    Volker Böhm
+ * Copyright: Volker Böhm
+ * Version:   1.0
+ * ---------------------------------------------------------------------------------------------------
+ */
+
+#ifndef __SETTLEDETECTOR_H
+#define __SETTLEDETECTOR_H
+
+#include "StdInclude.h"
+
+class SettleDetector {
+public:
+
+    static const uint8_t WINDOW_SAMPLES = 8;
+
+    /**
+     * Default threshold: variance of 4, standard deviation of 2
+     */
+    static const uint16_t DEFAULT_MAX_VARIANCE = 4;
+
+    SettleDetector() : mMaxVariance(DEFAULT_MAX_VARIANCE), mWindowsLeft(0), mMean(0), mSettled(false)
+    {
+        clearWindow();
+    }
+
+    /**
+     * Sets the variance threshold
+     * @param maxVariance maximal variance of a settled window
+     */
+    void setMaxVariance(uint16_t maxVariance) { mMaxVariance = maxVariance; }
+
+    /**
+     * Starts a new detection
+     * @param maxWindows amount of windows to wait at most
+     */
+    void start(uint8_t maxWindows)
+    {
+        mWindowsLeft = maxWindows;
+        mSettled = false;
+        clearWindow();
+    }
+
+    /**
+     * Adds a sample
+     * @param sample analog value 0 .. 1023
+     * @return true, if the value is settled or the maximal amount of windows is reached
+     */
+    bool add(value_t sample)
+    {
+        if (mWindowsLeft == 0) {
+            return true;
+        }
+        mSum += sample;
+        mSumOfSquares += uint32_t(sample) * sample;
+        mSamples++;
+        if (mSamples == WINDOW_SAMPLES) {
+            mMean = (mSum + WINDOW_SAMPLES / 2) / WINDOW_SAMPLES;
+            // n^2 * variance = n * sum(x^2) - sum(x)^2
+            uint32_t scaledVariance = WINDOW_SAMPLES * mSumOfSquares - mSum * mSum;
+            mSettled = scaledVariance <= uint32_t(mMaxVariance) * WINDOW_SAMPLES * WINDOW_SAMPLES;
+            mWindowsLeft = mSettled ? 0 : mWindowsLeft - 1;
+            clearWindow();
+        }
+        return mWindowsLeft == 0;
+    }
+
+    /**
+     * Checks, if the last detection ended with a settled value (and not by the maximal wait)
+     */
+    bool isSettled() const { return mSettled; }
+
+    /**
+     * Gets the mean of the last complete window
+     */
+    value_t getMean() const { return mMean; }
+
+private:
+
+    void clearWindow()
+    {
+        mSum = 0;
+        mSumOfSquares = 0;
+        mSamples = 0;
+    }
+
+    uint16_t mMaxVariance;
+    uint8_t  mWindowsLeft;
+    uint8_t  mSamples;
+    uint32_t mSum;
+    uint32_t mSumOfSquares;
+    value_t  mMean;
+    bool     mSettled;
+};
+
+#endif // __SETTLEDETECTOR_H
@@ -17,6 +17,8 @@
 #include "SerialTextIO.h"
 #include "RS485.h"
 #include "Device.h"
+#include "Diagnostics.h"
+#include "History.h"
 #include "Schedule.h"
 #include "Activity.h"
 #include "AnalogSensor.h"
@@ -41,8 +43,13 @@ void SpikeHome::init(value_t softwareVersion, device_t deviceAmount)
     Schedule::init();
 
     for (device_t deviceNo = 0; deviceNo < deviceAmount; deviceNo++) {
-        Schedule::addTarget(&Device::getConfig(deviceNo));
+        addToSchedule(&Device::getConfig(deviceNo));
     }
+    // Static, to not use the heap with the static topology (see StaticTopology.h)
+    static Diagnostics diagnostics;
+    addToSchedule(&diagnostics);
+    static History history;
+    addToSchedule(&history);
 
 }
 
@@ -74,23 +81,6 @@ void SpikeHome::initTextIO(value_t softwareVersion, device_t deviceAmount, time_
 
 }
 
-NotifyTarget* SpikeHome::onChange(device_t deviceNo, NotifyTarget* pTarget)
-{
-    Device::onChange(deviceNo, pTarget);
-    return pTarget;
-}
-
-NotifyTarget* SpikeHome::onChange(NotifyTarget* pTarget)
-{
-    return onChange(pTarget->getDeviceNo(), pTarget);
-}
-
-NotifyTarget* SpikeHome::addToSchedule(NotifyTarget* pTarget)
-{
-    Schedule::addTarget(pTarget);
-    return pTarget;
-}
-
 NotifyTarget* SpikeHome::addActivity(device_t deviceNo)
 {
     return onChange(addToSchedule(new Activity(deviceNo)));
@@ -22,6 +22,7 @@
 #include "StdInclude.h"
 #include "Switches.h"
 #include "Schedule.h"
+#include "Device.h"
 
 class BinarySensor;
 
@@ -60,7 +61,13 @@ public:
      * @param pTarget sensor to register
      * @return pTarget, to use for further function calls.
      */
-    static NotifyTarget* onChange(device_t deviceNo, NotifyTarget* pTarget);
+    template <class T>
+    static T* onChange(device_t deviceNo, T* pTarget)
+    {
+        pTarget->setObjectSize(sizeof(T));
+        Device::onChange(deviceNo, pTarget);
+        return pTarget;
+    }
 
     /**
      * registers a notification target for change notifications of a
@@ -68,14 +75,25 @@ public:
      * @param pTarget sensor to register
      * @return pTarget, to use for further function calls.
      */
-    static NotifyTarget* onChange(NotifyTarget* pTarget);
+    template <class T>
+    static T* onChange(T* pTarget)
+    {
+        return onChange(pTarget->getDeviceNo(), pTarget);
+    }
 
     /**
      * Adds a notification target to the scheduling loop that is called regularily
+     * The size of the object is remembered for memory diagnostics.
      * @param pTarget pointer to a NotifyTarget class
      * @return pTarget, to use for further function calls.
      */
-    static NotifyTarget* addToSchedule(NotifyTarget* pTarget);
+    template <class T>
+    static T* addToSchedule(T* pTarget)
+    {
+        pTarget->setObjectSize(sizeof(T));
+        Schedule::addTarget(pTarget);
+        return pTarget;
+    }
 
     /**
      * Creates an light activity object and registeres it to the device
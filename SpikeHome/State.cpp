@@ -11,17 +11,27 @@
  */
 
 #include "State.h"
+#include "Schedule.h"
+#include "PinEvents.h"
+#include "AnalogScan.h"
+#include "DigitalInputs.h"
+#include "Aggregate.h"
+#include "History.h"
 
 State::State(device_t deviceNo, key_t notify)
-    : NotifyTarget(deviceNo), mNotifyKey(notify), mLastValue(0)
+    : NotifyTarget(deviceNo), mNotifyKey(notify), mLastValue(0), mCapturedLevel(LEVEL_NOT_CAPTURED),
+      mpAggregate(0), mAggregationEnabled(false)
 {
     mLoopsOnLastStateSend = 0;
     NotifyTarget::setCheckMask(NotifyTarget::CHECKSTATE_NORMAL);
+    // Sensors only send changes, subclasses subscribe the keys they handle
+    NotifyTarget::unsubscribeAll();
+    mReportPolicy.setSigned(StateValue::getDecimals(notify) != 0);
 }
 
 value_t State::analogReadState(pin_t pin, bool inverted)
 {
-    value_t state = analogRead(pin);
+    value_t state = AnalogScan::read(pin);
     if (inverted) {
         state = MAX_ANALOG_READ_VALUE - state;
     }
@@ -33,10 +43,10 @@ value_t State::digitalReadState(pin_t pin, bool invert)
     value_t state;
     bool isPinAnalog = pin >= A0;
     if (isPinAnalog) {
-        state = analogRead(pin);
+        state = AnalogScan::read(pin);
         state = (state <= 100) ? LOW : HIGH;
     } else {
-        state = digitalRead(pin);
+        state = DigitalInputs::read(pin);
     }
     if (invert) {
         state = state == LOW ? HIGH : LOW;
@@ -56,6 +66,32 @@ void State::setPullup(pin_t pin)
     }
 }
 
+bool State::captureEdges(pin_t pin)
+{
+    bool result = PinEvents::attach(pin, this);
+    if (result) {
+        mCapturedLevel = digitalRead(pin);
+    }
+    return result;
+}
+
+value_t State::readState(pin_t pin, bool invert)
+{
+    value_t state;
+    if (mCapturedLevel == LEVEL_NOT_CAPTURED) {
+        state = digitalReadState(pin, invert);
+    } else {
+        state = (mCapturedLevel == HIGH) != invert ? HIGH : LOW;
+    }
+    return state;
+}
+
+void State::handleEdge(uint8_t level)
+{
+    mCapturedLevel = level;
+    checkState(Schedule::getLoops());
+}
+
 void State::checkState(time_t scheduleLoops)
 {
     StateValue curValue = getValue();
@@ -63,22 +99,105 @@ void State::checkState(time_t scheduleLoops)
 
     if (hasChangedFlag) {
         notifyChange(curValue);
-        mLastValue = curValue;
+        storeChange(curValue);
+    }
+    reportIfDue(curValue, scheduleLoops);
+}
+
+void State::storeChange(StateValue curValue)
+{
+    mLastValue = curValue;
+    mNotifyServer = true;
+    if (mNotifyKey != 0) {
+        History::record(getDeviceNo(), mNotifyKey, curValue.toInt());
+    }
+}
+
+bool State::maySend(time_t scheduleLoops)
+{
+    time_t loopsSinceLastStateSend = scheduleLoops - mLoopsOnLastStateSend;
+    bool enoughTime = loopsSinceLastStateSend >= mReportPolicy.get(ReportPolicy::MIN_INTERVAL) * LOOPS_PER_SECOND;
+    return enoughTime;
+}
+
+void State::reportIfDue(StateValue curValue, time_t scheduleLoops)
+{
+    if (mpAggregate != 0 && mpAggregate->isActive()) {
+        // Changes are part of the next aggregate record
+        mNotifyServer = false;
+        mpAggregate->add(curValue.toInt());
+        if (mpAggregate->isWindowElapsed(scheduleLoops)) {
+            mpAggregate->closeWindow(scheduleLoops);
+        }
+        if (mpAggregate->isRecordPending()) {
+            requestReport();
+        }
+        return;
+    }
+    value_t heartbeatInSeconds = mReportPolicy.get(ReportPolicy::HEARTBEAT);
+    if (heartbeatInSeconds != 0 && scheduleLoops - mLoopsOnLastStateSend >= heartbeatInSeconds * LOOPS_PER_SECOND) {
         mNotifyServer = true;
     }
     if (mNotifyServer && maySend(scheduleLoops)) {
-        if (notifyServer(curValue)) {
+        if (requestReport()) {
             mLoopsOnLastStateSend = scheduleLoops;
             mNotifyServer = false;
         }
     }
 }
 
-bool State::maySend(time_t scheduleLoops)
+void State::setReportPolicy(value_t absolute, value_t relativePercent, value_t minIntervalInSeconds,
+    value_t heartbeatInSeconds)
 {
-    time_t loopsSinceLastStateSend = scheduleLoops - mLoopsOnLastStateSend;
-    bool enoughTime = loopsSinceLastStateSend >= MIN_LOOPS_BETWEEN_SEND_IN_SECONDS;
-    return enoughTime;
+    value_t defaults[ReportPolicy::PARAMETERS] = { absolute, relativePercent, minIntervalInSeconds, heartbeatInSeconds };
+    for (uint8_t parameter = 0; parameter < ReportPolicy::PARAMETERS; parameter++) {
+        key_t key = ReportPolicy::getKey(mNotifyKey, parameter);
+        if (key == ReportPolicy::NO_POLICY_KEY) {
+            mReportPolicy.set(parameter, defaults[parameter]);
+        } else {
+            mReportPolicy.set(parameter, addConfigValue(key, defaults[parameter]));
+            NotifyTarget::subscribe(key);
+        }
+    }
+}
+
+void State::setAggregation(value_t windowInSeconds)
+{
+    key_t key = Aggregate::getWindowKey(mNotifyKey);
+    if (key != Aggregate::NO_WINDOW_KEY) {
+        mAggregationEnabled = true;
+        NotifyTarget::subscribe(key);
+        // The window stored in the configuration may differ from the default
+        setAggregationWindow(addConfigValue(key, windowInSeconds));
+    }
+}
+
+value_t State::setAggregationWindow(value_t windowInSeconds)
+{
+    value_t maxWindow = Aggregate::getMaxWindow(getCheckMask());
+    if (windowInSeconds > maxWindow) {
+        windowInSeconds = maxWindow;
+    }
+    if (mpAggregate == 0 && windowInSeconds != 0) {
+        mpAggregate = new Aggregate(windowInSeconds);
+    }
+    if (mpAggregate != 0) {
+        mpAggregate->setWindow(windowInSeconds, Schedule::getLoops());
+    }
+    return windowInSeconds;
+}
+
+void State::handleChange(address_t senderAddress, key_t key, StateValue data)
+{
+    if (mAggregationEnabled && key == Aggregate::getWindowKey(mNotifyKey)) {
+        setConfigValue(key, setAggregationWindow(data.toInt()));
+    }
+    for (uint8_t parameter = 0; parameter < ReportPolicy::PARAMETERS; parameter++) {
+        if (key == ReportPolicy::getKey(mNotifyKey, parameter) && key != ReportPolicy::NO_POLICY_KEY) {
+            setConfigValue(key, data.toInt());
+            mReportPolicy.set(parameter, data.toInt());
+        }
+    }
 }
 
 
@@ -98,6 +217,30 @@ bool State::notifyServer(StateValue value)
     return result;
 }
 
+bool State::sendReport()
+{
+    if (mpAggregate != 0 && mpAggregate->isRecordPending()) {
+        return sendAggregate();
+    }
+    return notifyServer(mLastValue);
+}
+
+bool State::sendAggregate()
+{
+    uint8_t message = mpAggregate->getMessage();
+    bool sent;
+    if (message == 0) {
+        sent = sendToServer(AGGREGATE_ID_NOTIFICATION, StateValue(value_t(mNotifyKey)));
+    } else {
+        sent = sendToServer(AGGREGATE_VALUE_NOTIFICATION, StateValue(mpAggregate->getRecordValue(message - 1)));
+    }
+    if (sent) {
+        mpAggregate->nextMessage();
+    }
+    // The report stays queued until the last message of the record is sent, one message per schedule loop
+    return !mpAggregate->isRecordPending();
+}
+
 bool State::notifyServer(uint16_t loopCount)
 {
     StateValue value = getValue();
@@ -17,6 +17,9 @@
 #define STATE_H
 
 #include "StdInclude.h"
+#include "ReportPolicy.h"
+
+class Aggregate;
 
 class State : public NotifyTarget {
 public:
@@ -36,15 +39,17 @@ public:
      */
     virtual void checkState(time_t scheduleLoops);
 
-   /**
-    * Handles a change notification. This function is called by Notify if the object is registered
-    * @param notifyType type of the change
-    * @param float data new value
-    */
-    virtual void handleChange(address_t senderAddress, key_t notifyType, float data) {};
+    /**
+     * Handles changes of the report policy parameters and of the aggregation window (see setReportPolicy,
+     * setAggregation)
+     * @param key key/identifier of the change
+     * @param data new value
+     */
+    virtual void handleChange(address_t senderAddress, key_t key, StateValue data);
 
     /**
-     * Reads an analog value from an analog input pin
+     * Reads an analog value from an analog input pin. Returns the latest average of the
+     * interrupt driven scan (see AnalogScan), only the first read of a pin is blocking.
      * @param pin analog pin to read from
      * @param inverted true, if value is inverted
      * @return analog value of pin, invertet if mInvert = true
@@ -53,7 +58,7 @@ public:
 
     /**
      * Reads the status of an input pin as digital value. The pin may either be an analog or a digital pin
-     * On Analog pins values > 100 are concidered as HIGH.
+     * On Analog pins values > 100 are concidered as HIGH. Digital pins are debounced (see DigitalInputs).
      * @param pin pin (analog or digital) to read from
      * @param inverted true, if value is inverted
      * @returns the status value either "LOW" or "HIGH"
@@ -67,24 +72,82 @@ public:
      */
     static void setPullup(pin_t pin);
 
+    /**
+     * Handles a captured edge of the pin, called by PinEvents from the schedule. Reads the state
+     * with the new level and notifies changes immediately.
+     * @param level pin level after the edge (HIGH or LOW)
+     */
+    virtual void handleEdge(uint8_t level);
+
+    /**
+     * Captured level of a pin without edge capture
+     */
+    static const uint8_t LEVEL_NOT_CAPTURED = 0xFF;
+
 protected:
 
+    /**
+     * Captures the edges of a pin by interrupt instead of polling it (see PinEvents). Falls back
+     * to polling, if the pin has no interrupt.
+     * @param pin digital pin to capture
+     * @return true, if the pin is captured
+     */
+    bool captureEdges(pin_t pin);
+
+    /**
+     * Reads the status of the pin of the state. Returns the level of the last captured edge, if
+     * the pin is captured, else reads the pin (see digitalReadState).
+     * @param pin pin (analog or digital) to read from
+     * @param inverted true, if value is inverted
+     * @returns the status value either "LOW" or "HIGH"
+     */
+    value_t readState(pin_t pin, bool invert);
+
     /*
      * Reads/Gets the current status value
      */
     virtual StateValue getValue() { return 0; }
 
     /**
-     * Checks if the state has changed.
+     * Checks if the state has changed enough to be reported (see ReportPolicy::exceedsDeadband)
      * @param mCurValue current state value
      * @param mLastValue last state value
      * @return true, if state has changed
      */
     virtual bool hasChanged(StateValue curValue, StateValue lastValue)
     {
-        return curValue.toInt() != lastValue.toInt();
+        return mReportPolicy.exceedsDeadband(curValue.toInt(), lastValue.toInt());
     };
 
+    /**
+     * Makes the report policy configurable at runtime. The parameters are stored in the configuration
+     * of the device with keys derived from the notify key (see ReportPolicy::getKey).
+     * @param absolute default of the absolute deadband
+     * @param relativePercent default of the relative deadband in percent
+     * @param minIntervalInSeconds default of the minimal time between two reports
+     * @param heartbeatInSeconds default of the maximal time without report, 0 = no heartbeat
+     */
+    void setReportPolicy(value_t absolute, value_t relativePercent, value_t minIntervalInSeconds,
+        value_t heartbeatInSeconds);
+
+    /**
+     * Makes the aggregation of the samples configurable at runtime (see Aggregate.h). While a window is
+     * set, the server gets an aggregate record at window end instead of the changes. Targets of the
+     * device are still notified about every change. Aggregate integer values only, not StateValues
+     * having a fraction. The aggregate is allocated when a window is set for the first time, a sensor
+     * without window needs no memory for it.
+     * @param windowInSeconds default of the window length, 0 = no aggregation
+     */
+    void setAggregation(value_t windowInSeconds);
+
+    /**
+     * Sets the length of the aggregation window, allocates the aggregate for the first window. The window
+     * is limited to Aggregate::getMaxWindow of the check mask.
+     * @param windowInSeconds length of the window, 0 = no aggregation
+     * @return window length set
+     */
+    value_t setAggregationWindow(value_t windowInSeconds);
+
     /**
      * Sends a notification on change.
      * @param value changed value
@@ -105,6 +168,19 @@ protected:
      */
     virtual bool notifyServer(uint16_t loopCount);
 
+    /**
+     * Sends the last state to the server, called by the schedule after a change (see requestReport)
+     * @return true, if the server could be notified
+     */
+    virtual bool sendReport();
+
+
+    /**
+     * Stores a changed value as last value and requests a report. The change is recorded in the history
+     * while the server is not connected (see History.h).
+     * @param curValue changed value
+     */
+    void storeChange(StateValue curValue);
 
     /**
      * Retuns true, if the sensor may send its state because enough time is elapsed
@@ -112,6 +188,20 @@ protected:
      */
     bool maySend(time_t scheduleLoops);
 
+    /**
+     * Requests a report of a changed value or of the heartbeat, if the minimal interval is elapsed.
+     * If the samples are aggregated, adds the value to the window and requests a report at window end.
+     * @param curValue value of the current sample
+     * @param scheduleLoops number of checkState loops since reboot
+     */
+    void reportIfDue(StateValue curValue, time_t scheduleLoops);
+
+    /**
+     * Sends the next message of a pending aggregate record
+     * @return true, if the record is sent completely
+     */
+    bool sendAggregate();
+
     /**
      * Reads sensor value and notifies registered objects and server about changes
      * @param timeElapsedInSeconds time elapsed in seconds since server reboot
@@ -122,10 +212,10 @@ protected:
     StateValue mLastValue;
     time_t     mLoopsOnLastStateSend;
     bool       mNotifyServer;
-
-private:
-
-    static const time_t MIN_LOOPS_BETWEEN_SEND_IN_SECONDS = 5 * LOOPS_PER_SECOND;
+    uint8_t    mCapturedLevel;
+    ReportPolicy mReportPolicy;
+    Aggregate*   mpAggregate;
+    bool         mAggregationEnabled;
 };
 
 #endif //STATE_H
@@ -5,10 +5,11 @@
  * any purpose.
  *
  * File:      StateValue.h
- * Purpose:   Stores sensor values in a two byte integer either from float or from integer
- *            Declares basic types.
- *            Floats are not used due to save memory. If memory will not be relevant in future this
- *            could be changed
+ * Purpose:   Stores sensor values in a two byte integer. Declares basic types.
+ *            Temperatures and humidity are signed fixed point values in hundredths (-327.68 .. 327.67),
+ *            the decimals of a key are given by getDecimals. Sensors and actuators calculate with
+ *            integers only. The float constructor and toFloat are left out with SPIKEHOME_NO_FLOAT
+ *            (see StdInclude.h), thus the float library is not linked.
  *            This implementation is not good, but memory saving. Do not:
  *            Implement operator==, operator!= or conversion operations because that might lead to
  *            comparing integers with floats with false results
@@ -26,6 +27,8 @@
 class StateValue {
 public:
 
+  static const int16_t HUNDREDTHS = 100;
+
   /**
    * Creates a value with a predecimal part and decimal places
    * @param intPlaces predecimal part of the value
@@ -56,17 +59,16 @@ public:
   {
   }
 
+#ifndef SPIKEHOME_NO_FLOAT
   /**
-   * Creates a state value from a float. The intplaces are put in the first byte
-   * the dec places in the second byte. Negative values or values > 255 are not supported
-   * @param value float value
+   * Creates a fixed point state value in hundredths from a float
+   * @param value float value (-327.68 .. 327.67)
    */
   StateValue(double value)
+      :valueStore(uint16_t(int16_t(round(value * HUNDREDTHS))))
   {
-      uint16_t intPlaces = floor(value);
-      uint16_t decPlaces = round((value - intPlaces) * 100.0);
-      setValue(intPlaces, decPlaces);
   }
+#endif
 
   /**
    * Creates a state value from a byte array. The first of the array byte is copyied to the
@@ -97,6 +99,15 @@ public:
       return valueStore;
   }
 
+  /**
+   * Gets the value as signed integer, used for fixed point values
+   * @return value, in hundredths for fixed point values
+   */
+  int16_t toSigned() const
+  {
+      return int16_t(valueStore);
+  }
+
   /**
    * Gets the least significant byte of the value
    * @return least significant byte
@@ -113,15 +124,54 @@ public:
       return valueStore >> 8;
   }
 
+#ifndef SPIKEHOME_NO_FLOAT
   /**
-   * Converts the value to a float using the most significant byte for the int places and
-   * the least significant byte for the dec places
-   * @return
+   * Converts a fixed point value in hundredths to a float
+   * @return float value
    */
   float toFloat() const
   {
-      float decPlaces = (float) (getDecPlaces()) / 100.0;
-      return getIntPlaces() + decPlaces;
+      return toSigned() / float(HUNDREDTHS);
+  }
+#endif
+
+  /**
+   * Gets the amount of decimals of the values of a key
+   * @param key key of the value
+   * @return 2 for temperatures ('t', 's') and humidity ('h'), else 0
+   */
+  static uint8_t getDecimals(key_t key)
+  {
+      return key == NotifyKeys::TEMPERATURE_NOTIFICATION || key == NotifyKeys::SYS_TEMPERATURE_NOTIFICATION ||
+          key == NotifyKeys::HUMIDITY_NOTIFICATION ? 2 : 0;
+  }
+
+  /**
+   * Prints the value scaled for its key: fixed point values with their decimals, the air pressure ('p')
+   * in Pa, all other values as unsigned integer
+   * @param out stream to print to
+   * @param key key of the value
+   */
+  void print(Print& out, key_t key) const
+  {
+      if (key == NotifyKeys::AIR_PRESSURE_NOTIFICATION) {
+          out.print(toInt() * 2L);
+      } else if (getDecimals(key) == 0) {
+          out.print(toInt());
+      } else {
+          int16_t value = toSigned();
+          uint16_t magnitude = value < 0 ? uint16_t(-int32_t(value)) : uint16_t(value);
+          if (value < 0) {
+              out.print('-');
+          }
+          out.print(magnitude / HUNDREDTHS);
+          out.print('.');
+          uint8_t fraction = magnitude % HUNDREDTHS;
+          if (fraction < 10) {
+              out.print('0');
+          }
+          out.print(fraction);
+      }
   }
 
   private:
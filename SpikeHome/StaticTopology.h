@@ -0,0 +1,337 @@
+/**
+ * ---------------------------------------------------------------------------------------------------
+ * This software is licensed under the GNU LESSER GENERAL PUBLIC LICENSE Version 3. It is furnished
+ * "as is", without any support, and with no warranty, express or implied, as to its usefulness for
+ * any purpose.
+ *
+ * File:      StaticTopology.h
+ * Purpose:   Declarative alternative to the SpikeHome::add... functions. The devices and their
+ *            sensors are declared as types, every object gets its own static memory. No heap is
+ *            used, the memory needed is known at link time and the amount of change listeners
+ *            per device is checked by the compiler. Example:
+ *
+ *            typedef StaticTopology<
+ *                StaticDevice<0, ActivityNode, LightNode<A3, 3>, MovementSensorNode<4> >,
+ *                StaticDevice<1, DHTSensorNode<12>, WindowSensorNode<A2> >
+ *            > Topology;
+ *
+ *            void setup()
+ *            {
+ *                SpikeHome::initRS485(SOFTWARE_VERSION, Topology::DEVICE_AMOUNT, 57600, 10);
+ *                Topology::setup();
+ *            }
+ *
+ *            The objects are constructed by setup, as their constructors read the device configuration.
+ *            Nodes needing additional libraries are declared in SpikeSensors/StaticSensors.h.
+ *            Non-goal: a constant-initialised dispatch table. Notify keeps its array of change listeners
+ *            per device, it is filled by setup like with the add... functions, since the listeners are
+ *            registered by the node setup after their construction. Its size is still checked by the compiler.
+ *
+ * Author:    Volker Böhm
+ * Copyright: Volker Böhm
+ * Version:   1.0
+ * ---------------------------------------------------------------------------------------------------
+ */
+
+#ifndef __STATICTOPOLOGY_H
+#define __STATICTOPOLOGY_H
+
+#include "StdInclude.h"
+#include "SpikeHome.h"
+#include "Activity.h"
+#include "AnalogSensor.h"
+#include "BinarySensor.h"
+#include "BrightnessSensor.h"
+#include "DHTSensor.h"
+#include "FS20UART.h"
+#include "Light.h"
+#include "MovementSensor.h"
+#include "RollerShutter.h"
+#include "StatusLED.h"
+#include "WaterSensor.h"
+
+/**
+ * Memory of a statically allocated object, used with the placement new below
+ */
+class StaticPlace {
+public:
+    explicit StaticPlace(uint8_t* pStorage) : mpStorage(pStorage) {}
+    uint8_t* mpStorage;
+};
+
+/**
+ * Constructs an object in static memory. An own overload, older AVR cores do not provide <new>
+ */
+inline void* operator new(size_t size, const StaticPlace& place)
+{
+    return place.mpStorage;
+}
+
+/**
+ * Nodes: one node type for every SpikeHome::add... function. A node defines the class of the object
+ * (Target), the amount of change listeners it registers (LISTENERS) and creates and registers the
+ * object in static memory (setup).
+ */
+class ActivityNode {
+public:
+    typedef Activity Target;
+    static const uint8_t LISTENERS = 1;
+    static void setup(device_t deviceNo, const StaticPlace& place)
+    {
+        SpikeHome::onChange(SpikeHome::addToSchedule(new (place) Activity(deviceNo)));
+    }
+};
+
+template <pin_t PIN, bool INVERT, key_t NOTIFY_KEY>
+class AnalogSensorNode {
+public:
+    typedef AnalogSensor Target;
+    static const uint8_t LISTENERS = 0;
+    static void setup(device_t deviceNo, const StaticPlace& place)
+    {
+        SpikeHome::addToSchedule(new (place) AnalogSensor(deviceNo, PIN, INVERT, NOTIFY_KEY));
+    }
+};
+
+template <pin_t PIN, bool INVERT, key_t NOTIFY_KEY>
+class BinarySensorNode {
+public:
+    typedef BinarySensor Target;
+    static const uint8_t LISTENERS = 0;
+    static void setup(device_t deviceNo, const StaticPlace& place)
+    {
+        SpikeHome::addToSchedule(new (place) BinarySensor(deviceNo, PIN, INVERT, NOTIFY_KEY));
+    }
+};
+
+template <pin_t PIN>
+class BrightnessSensorNode {
+public:
+    typedef BrightnessSensor Target;
+    static const uint8_t LISTENERS = 0;
+    static void setup(device_t deviceNo, const StaticPlace& place)
+    {
+        SpikeHome::addToSchedule(new (place) BrightnessSensor(deviceNo, PIN));
+    }
+};
+
+template <pin_t PIN>
+class DHTSensorNode {
+public:
+    typedef DHTSensor Target;
+    static const uint8_t LISTENERS = 0;
+    static void setup(device_t deviceNo, const StaticPlace& place)
+    {
+        SpikeHome::addToSchedule(new (place) DHTSensor(deviceNo, PIN));
+    }
+};
+
+template <pin_t RX_PIN, pin_t TX_PIN>
+class FS20UARTNode {
+public:
+    typedef FS20UART Target;
+    static const uint8_t LISTENERS = 0;
+    static void setup(device_t deviceNo, const StaticPlace& place)
+    {
+        SpikeHome::addToSchedule(new (place) FS20UART(deviceNo, RX_PIN, TX_PIN));
+    }
+};
+
+template <pin_t BRIGHTNESS_PIN, pin_t PWM_PIN>
+class LightNode {
+public:
+    typedef Light Target;
+    static const uint8_t LISTENERS = 1;
+    static void setup(device_t deviceNo, const StaticPlace& place)
+    {
+        SpikeHome::onChange(SpikeHome::addToSchedule(new (place) Light(deviceNo, BRIGHTNESS_PIN, PWM_PIN)));
+    }
+};
+
+template <pin_t PIN, uint8_t ACTIVE_VALUE = 1>
+class MovementSensorNode {
+public:
+    typedef MovementSensor Target;
+    static const uint8_t LISTENERS = 0;
+    static void setup(device_t deviceNo, const StaticPlace& place)
+    {
+        SpikeHome::addToSchedule(new (place) MovementSensor(deviceNo, PIN, ACTIVE_VALUE));
+    }
+};
+
+template <pin_t POWER_PIN, pin_t DIRECTION_PIN>
+class RollerShutterNode {
+public:
+    typedef RollerShutter Target;
+    static const uint8_t LISTENERS = 0;
+    static void setup(device_t deviceNo, const StaticPlace& place)
+    {
+        SpikeHome::addToSchedule(new (place) RollerShutter(deviceNo, POWER_PIN, DIRECTION_PIN));
+    }
+};
+
+template <pin_t PIN, key_t STATUS_KEY>
+class StatusLEDNode {
+public:
+    typedef StatusLED Target;
+    static const uint8_t LISTENERS = 1;
+    static void setup(device_t deviceNo, const StaticPlace& place)
+    {
+        SpikeHome::onChange(new (place) StatusLED(deviceNo, PIN, STATUS_KEY));
+    }
+};
+
+template <uint16_t PIN_BIT_MASK_LSB_D2>
+class SwitchesNode {
+public:
+    typedef Switches Target;
+    static const uint8_t LISTENERS = 0;
+    static void setup(device_t deviceNo, const StaticPlace& place)
+    {
+        SpikeHome::addToSchedule(new (place) Switches(deviceNo, PIN_BIT_MASK_LSB_D2));
+    }
+};
+
+template <pin_t PIN>
+class WaterSensorNode {
+public:
+    typedef WaterSensor Target;
+    static const uint8_t LISTENERS = 0;
+    static void setup(device_t deviceNo, const StaticPlace& place)
+    {
+        SpikeHome::addToSchedule(new (place) WaterSensor(deviceNo, PIN));
+    }
+};
+
+template <pin_t PIN>
+class WindowSensorNode {
+public:
+    typedef BinarySensor Target;
+    static const uint8_t LISTENERS = 0;
+    static void setup(device_t deviceNo, const StaticPlace& place)
+    {
+        BinarySensor* sensor = new (place) BinarySensor(deviceNo, PIN, NotifyTarget::NOT_INVERTED,
+            NotifyTarget::WINDOW_OPEN_NOTIFICATION);
+        SpikeHome::addToSchedule(sensor);
+        sensor->setPullup();
+    }
+};
+
+/**
+ * Static memory of one node. Every node of every device has its own memory, even if the node types are equal.
+ */
+template <device_t DEVICE_NO, uint8_t INDEX, class NODE>
+class StaticSlot {
+public:
+    static void setup()
+    {
+        NODE::setup(DEVICE_NO, StaticPlace(mStorage));
+    }
+
+    static const size_t SIZE = sizeof(typename NODE::Target);
+
+private:
+    static uint8_t mStorage[SIZE];
+};
+
+template <device_t DEVICE_NO, uint8_t INDEX, class NODE>
+uint8_t StaticSlot<DEVICE_NO, INDEX, NODE>::mStorage[StaticSlot<DEVICE_NO, INDEX, NODE>::SIZE];
+
+/**
+ * List of the nodes of a device, sets up the nodes in the order of declaration
+ */
+template <device_t DEVICE_NO, uint8_t INDEX, class... NODES>
+class StaticNodeList {
+public:
+    static const uint8_t LISTENERS = 0;
+    static const size_t  SIZE      = 0;
+    static void setup() {}
+};
+
+template <device_t DEVICE_NO, uint8_t INDEX, class NODE, class... NODES>
+class StaticNodeList<DEVICE_NO, INDEX, NODE, NODES...> {
+public:
+    typedef StaticNodeList<DEVICE_NO, INDEX + 1, NODES...> Rest;
+
+    static const uint8_t LISTENERS = NODE::LISTENERS + Rest::LISTENERS;
+    static const size_t  SIZE      = StaticSlot<DEVICE_NO, INDEX, NODE>::SIZE + Rest::SIZE;
+
+    static void setup()
+    {
+        StaticSlot<DEVICE_NO, INDEX, NODE>::setup();
+        Rest::setup();
+    }
+};
+
+/**
+ * A device with its nodes
+ */
+template <device_t DEVICE_NO, class... NODES>
+class StaticDevice {
+public:
+    typedef StaticNodeList<DEVICE_NO, 0, NODES...> Nodes;
+
+    static const device_t DEVICE    = DEVICE_NO;
+    static const size_t   SIZE      = Nodes::SIZE;
+
+    static_assert(Nodes::LISTENERS <= MAX_NOTIFY_TARGETS_PER_DEVICE, "Too many change listeners for one device");
+
+    static void setup()
+    {
+        Nodes::setup();
+    }
+};
+
+/**
+ * List of devices, sets up the devices in the order of declaration
+ */
+template <device_t DEVICE_AMOUNT, class... DEVICES>
+class StaticDeviceList {
+public:
+    static const size_t SIZE = 0;
+    static void setup() {}
+};
+
+template <device_t DEVICE_AMOUNT, class DEVICE, class... DEVICES>
+class StaticDeviceList<DEVICE_AMOUNT, DEVICE, DEVICES...> {
+public:
+    typedef StaticDeviceList<DEVICE_AMOUNT, DEVICES...> Rest;
+
+    static const size_t SIZE = DEVICE::SIZE + Rest::SIZE;
+
+    static_assert(DEVICE::DEVICE >= 0 && DEVICE::DEVICE < DEVICE_AMOUNT, "Device number out of range");
+
+    static void setup()
+    {
+        DEVICE::setup();
+        Rest::setup();
+    }
+};
+
+/**
+ * The devices of a sketch. The device numbers must be 0 .. DEVICE_AMOUNT - 1
+ */
+template <class... DEVICES>
+class StaticTopology {
+public:
+    typedef StaticDeviceList<sizeof...(DEVICES), DEVICES...> Devices;
+
+    static const device_t DEVICE_AMOUNT = sizeof...(DEVICES);
+
+    /**
+     * Memory of all nodes in bytes
+     */
+    static const size_t SIZE = Devices::SIZE;
+
+    static_assert(DEVICE_AMOUNT <= MAX_DEVICE_AMOUNT, "Too many devices");
+
+    /**
+     * Creates and registers all nodes. Call it after SpikeHome::init, initRS485 or initTextIO
+     */
+    static void setup()
+    {
+        Devices::setup();
+    }
+};
+
+#endif // __STATICTOPOLOGY_H
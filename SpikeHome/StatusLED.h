@@ -34,6 +34,8 @@ public:
     {
         pinMode(pin, OUTPUT);
         digitalWrite(pin, LOW);
+        NotifyTarget::unsubscribeAll();
+        NotifyTarget::subscribe(mStatusKey);
     }
 
     /**
@@ -30,7 +30,8 @@ typedef int16_t pos_t;
 /**
  * The following constants are limiting the amount of of sensors used in an Arduino.
  * You can safely change them if you have a look at the amount of memory available.
- * Use Trace::getFreeMemory() to view the memory left between heap and stack.
+ * Use Trace::getFreeMemory() to view the memory left between heap and stack and Memory::getUnusedStack()
+ * to view the worst case seen since reboot. Send {"K": "U", "V": 1} to get a memory dump (see Diagnostics.h).
  * As long as the memory is very limited it is better to not increase space for arrays
  * dynamically because this could lead to holes in the heap and thus again less memory...
  */
@@ -45,11 +46,23 @@ static const device_t MAX_DEVICE_AMOUNT = 5;
  */
 static const uint16_t MAX_NOTIFY_TARGETS_PER_DEVICE = 5;
 
+/**
+ * Leaves out the float interface of StateValue, the library then calculates with integers only and the
+ * float library is not linked. Define it here or with the compiler flags (-DSPIKEHOME_NO_FLOAT), if the
+ * sketch does not use floats.
+ */
+//#define SPIKEHOME_NO_FLOAT
+
 /**
  * Supports tracing/debugging.
  */
 #include "Trace.h"
 
+/**
+ * Keys of notifications and configuration values
+ */
+#include "NotifyKeys.h"
+
 /**
  * Basic data type to store sensor variables
  */
@@ -18,6 +18,8 @@ Switches::Switches(device_t deviceNo, switch_t pins)
     init(pins);
     value_t storedValue = addConfigValue(SWITCH_STATUS_KEY, 0x00);
     setAll(storedValue);
+    NotifyTarget::unsubscribeAll();
+    NotifyTarget::subscribe(SWITCH_STATUS_KEY);
 }
 
 Switches::switch_t Switches::getCurValues()
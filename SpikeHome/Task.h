@@ -0,0 +1,146 @@
+/**
+ * ---------------------------------------------------------------------------------------------------
+ * This software is licensed under the GNU LESSER GENERAL PUBLIC LICENSE Version 3. It is furnished
+ * "as is", without any support, and with no warranty, express or implied, as to its usefulness for
+ * any purpose.
+ *
+ * File:      Task.h
+ * Purpose:   Cooperative tasks (stackless coroutines, "protothreads") for notify targets. A task is a
+ *            method returning bool written as straight-line code that gives control back to the
+ *            schedule while waiting. The position to continue is stored in a Task object. Example:
+ *
+ *            bool Sensor::runMeasurement()
+ *            {
+ *                TASK_BEGIN(mTask);
+ *                digitalWrite(mPin, HIGH);
+ *                TASK_WAIT_MS(mTask, 20);
+ *                TASK_WAIT_UNTIL(mTask, digitalRead(mInputPin) == LOW);
+ *                mValue = analogRead(mAnalogPin);
+ *                TASK_END(mTask);
+ *            }
+ *
+ *            The method is called from checkState and returns true while the task is running.
+ *            TASK_WAIT_MS declares the end of the wait to the schedule (NotifyTarget::checkAgainIn),
+ *            thus the macros must be used in methods of a NotifyTarget.
+ *            Restrictions: local variables are lost while waiting (use members) and the macros must
+ *            not be used inside a switch statement.
+ *
+ * Author:    Volker Böhm
+ * Copyright: Volker Böhm
+ * Version:   1.0
+ * ---------------------------------------------------------------------------------------------------
+ */
+
+#ifndef __TASK_H
+#define __TASK_H
+
+#include "StdInclude.h"
+
+class Task {
+public:
+
+    typedef uint16_t line_t;
+
+    static const line_t START    = 0;
+    static const line_t FINISHED = 0xFFFF;
+
+    /**
+     * Longest deadline the schedule handles (see NotifyTarget::checkAgainIn), about 327 seconds
+     */
+    static const uint16_t MAX_WAIT_LOOPS = 0x7FFF;
+
+    Task() : mLine(START), mWakeUpTime(0) {}
+
+    /**
+     * Restarts the task. The next call of the task method starts at TASK_BEGIN
+     */
+    void restart()
+    {
+        mLine = START;
+    }
+
+    /**
+     * Checks, if the task reached TASK_END
+     * @return true, if the task is finished
+     */
+    bool isFinished()
+    {
+        return mLine == FINISHED;
+    }
+
+    /**
+     * Sets the time a wait ends
+     * @param milliseconds time to wait from now
+     */
+    void setWakeUpTime(time_t milliseconds)
+    {
+        mWakeUpTime = millis() + milliseconds;
+    }
+
+    /**
+     * Checks, if the wait time is over
+     * @return true, if the wake up time is reached
+     */
+    bool isTimeReached()
+    {
+        return int32_t(millis() - mWakeUpTime) >= 0;
+    }
+
+    /**
+     * Gets the time left until the wake up time
+     * @return milliseconds to wait, 0 if the wake up time is reached
+     */
+    time_t getRemainingTime()
+    {
+        return isTimeReached() ? 0 : mWakeUpTime - millis();
+    }
+
+    /**
+     * Calculates the amount of schedule loops to wait for a time (rounded up). The result is limited to
+     * MAX_WAIT_LOOPS, longer waits are split by TASK_WAIT_MS.
+     * @param milliseconds time to wait
+     * @return amount of loops, at most MAX_WAIT_LOOPS
+     */
+    static uint16_t toLoops(time_t milliseconds)
+    {
+        time_t loops = (milliseconds + NotifyTarget::MILLISECONDS_PER_LOOP - 1) / NotifyTarget::MILLISECONDS_PER_LOOP;
+        return loops > MAX_WAIT_LOOPS ? MAX_WAIT_LOOPS : uint16_t(loops);
+    }
+
+    /**
+     * Position to continue the task, only used by the macros
+     */
+    line_t mLine;
+
+private:
+    time_t mWakeUpTime;
+};
+
+/**
+ * Starts the body of a task method. Continues at the position of the last wait
+ */
+#define TASK_BEGIN(task) switch ((task).mLine) { case Task::FINISHED: return false; case Task::START:
+
+/**
+ * Gives control back to the schedule, the task continues on the next call
+ */
+#define TASK_YIELD(task) do { (task).mLine = __LINE__; return true; case __LINE__: ; } while (0)
+
+/**
+ * Gives control back to the schedule until a condition is true. The condition is checked on every call
+ */
+#define TASK_WAIT_UNTIL(task, condition) do { (task).mLine = __LINE__; case __LINE__: if (!(condition)) { return true; } } while (0)
+
+/**
+ * Gives control back to the schedule for a time in milliseconds. Every call before the wake up time declares
+ * the remaining time as new deadline, thus waits longer than MAX_WAIT_LOOPS are split into several deadlines.
+ */
+#define TASK_WAIT_MS(task, milliseconds) do { (task).setWakeUpTime(milliseconds); (task).mLine = __LINE__; case __LINE__: \
+    if (!(task).isTimeReached()) { checkAgainIn(Task::toLoops((task).getRemainingTime())); return true; } } while (0)
+
+/**
+ * Ends the body of a task method. Further calls return false until the task is restarted
+ */
+#define TASK_END(task) } (task).mLine = Task::FINISHED; return false
+
+#endif // __TASK_H
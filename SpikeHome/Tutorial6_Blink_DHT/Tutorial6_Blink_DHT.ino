@@ -75,9 +75,10 @@ public:
         // check the type to use temperature changes only
         if (key == 't') {
             if (initialTemperature == 0) {
-                initialTemperature = data.toFloat();
+                initialTemperature = data.toSigned();
             } else {
-                loopsUntilBlink = 100 - (data.toFloat() - initialTemperature) * 100;
+                // Temperatures are in 1/100 degree celsius
+                loopsUntilBlink = 100 - (data.toSigned() - initialTemperature);
                 if (loopsUntilBlink < 10) {
                     loopsUntilBlink = 10;
                 }
@@ -117,7 +118,7 @@ public:
     }
 
     value_t blinks;
-    float   initialTemperature;
+    int16_t initialTemperature;
     int32_t loopsUntilBlink;
     
 };
@@ -14,36 +14,36 @@
  */
 
 #include "StdInclude.h"
-#include "State.h"
+#include "SensorT.h"
 
-class WaterSensor : public State {
+/**
+ * Scales the inverted analog value to 0 (no water) .. 32 and averages it. Rising values are
+ * increased to detect water faster.
+ */
+class WaterLevelFilter {
+public:
+    value_t filter(value_t rawValue, value_t lastValue) const
+    {
+        value_t state = rawValue / 32;
+        if (state > lastValue) {
+            state += 3;
+        }
+        return (lastValue * 3 + state) / 4;
+    }
+};
+
+class WaterSensor : public SensorT<AnalogPinReader, WaterLevelFilter, AnyChange> {
     public:
         /**
          * Constructs a water sensor
          * @param pin name/number of the input pin to use
          */
         WaterSensor(device_t deviceNo, pin_t pin)
-          : State(deviceNo, WATER_NOTIFICATION), mPin(pin)
+          : SensorT(deviceNo, WATER_NOTIFICATION, AnalogPinReader(pin, INVERTED))
         {
             pinMode(pin, INPUT);
             mLastValue = HIGH;
+            setAggregation(0);
         }
 
-    protected:
-
-        /**
-         * Reads the status of the water sensor on an analog input pin
-         * @return invertet read input (0 = no water), largest value = 32
-         */
-        virtual StateValue getValue() {
-
-            value_t state = analogReadState(mPin, INVERTED) / 32;
-            if (state > mLastValue.toInt()) {
-                state += 3;
-            }
-            return (mLastValue.toInt() * 3 + state) / 4;
-        }
-
-        pin_t  mPin;
-
 };
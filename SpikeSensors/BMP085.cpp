@@ -0,0 +1,103 @@
+/**
+ * ---------------------------------------------------------------------------------------------------
+ * This software is licensed under the GNU LESSER GENERAL PUBLIC LICENSE Version 3. It is furnished
+ * "as is", without any support, and with no warranty, express or implied, as to its usefulness for
+ * any purpose.
+ *
+ * File:      BMP085.cpp
+ * Author:    Volker Böhm
+ * Copyright: Volker Böhm
+ * ---------------------------------------------------------------------------------------------------
+ */
+
+#include <Wire.h>
+#include "BMP085.h"
+
+bool BMP085::begin()
+{
+    Wire.begin();
+    if (read(REGISTER_CHIP_ID, 1) != CHIP_ID) {
+        return false;
+    }
+    uint8_t reg = REGISTER_CALIBRATION;
+    mAC1 = read(reg, 2); reg += 2;
+    mAC2 = read(reg, 2); reg += 2;
+    mAC3 = read(reg, 2); reg += 2;
+    mAC4 = read(reg, 2); reg += 2;
+    mAC5 = read(reg, 2); reg += 2;
+    mAC6 = read(reg, 2); reg += 2;
+    mB1  = read(reg, 2); reg += 2;
+    mB2  = read(reg, 2); reg += 2;
+    mMB  = read(reg, 2); reg += 2;
+    mMC  = read(reg, 2); reg += 2;
+    mMD  = read(reg, 2);
+    return true;
+}
+
+void BMP085::startTemperature()
+{
+    write(REGISTER_CONTROL, COMMAND_TEMPERATURE);
+}
+
+int16_t BMP085::readTemperature()
+{
+    int32_t ut = read(REGISTER_DATA, 2);
+    int32_t x1 = ((ut - int32_t(mAC6)) * int32_t(mAC5)) >> 15;
+    int32_t x2 = (int32_t(mMC) << 11) / (x1 + mMD);
+    mB5 = x1 + x2;
+    return (mB5 + 8) >> 4;
+}
+
+void BMP085::startPressure()
+{
+    write(REGISTER_CONTROL, COMMAND_PRESSURE + (mOversampling << 6));
+}
+
+int32_t BMP085::readPressure()
+{
+    int32_t up = read(REGISTER_DATA, 3) >> (8 - mOversampling);
+
+    int32_t b6 = mB5 - 4000;
+    int32_t x1 = (int32_t(mB2) * ((b6 * b6) >> 12)) >> 11;
+    int32_t x2 = (int32_t(mAC2) * b6) >> 11;
+    int32_t x3 = x1 + x2;
+    int32_t b3 = (((int32_t(mAC1) * 4 + x3) << mOversampling) + 2) / 4;
+
+    x1 = (int32_t(mAC3) * b6) >> 13;
+    x2 = (int32_t(mB1) * ((b6 * b6) >> 12)) >> 16;
+    x3 = ((x1 + x2) + 2) >> 2;
+    uint32_t b4 = (uint32_t(mAC4) * uint32_t(x3 + 32768)) >> 15;
+    uint32_t b7 = (uint32_t(up) - b3) * (50000UL >> mOversampling);
+
+    int32_t p;
+    if (b7 < 0x80000000UL) {
+        p = (b7 * 2) / b4;
+    } else {
+        p = (b7 / b4) * 2;
+    }
+    x1 = (p >> 8) * (p >> 8);
+    x1 = (x1 * 3038) >> 16;
+    x2 = (-7357 * p) >> 16;
+    return p + ((x1 + x2 + 3791) >> 4);
+}
+
+void BMP085::write(uint8_t reg, uint8_t value)
+{
+    Wire.beginTransmission(ADDRESS);
+    Wire.write(reg);
+    Wire.write(value);
+    Wire.endTransmission();
+}
+
+uint32_t BMP085::read(uint8_t reg, uint8_t amount)
+{
+    Wire.beginTransmission(ADDRESS);
+    Wire.write(reg);
+    Wire.endTransmission();
+    Wire.requestFrom(ADDRESS, amount);
+    uint32_t result = 0;
+    for (uint8_t index = 0; index < amount; index++) {
+        result = (result << 8) | uint8_t(Wire.read());
+    }
+    return result;
+}
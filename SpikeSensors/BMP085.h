@@ -0,0 +1,117 @@
+/**
+ * ---------------------------------------------------------------------------------------------------
+ * This software is licensed under the GNU LESSER GENERAL PUBLIC LICENSE Version 3. It is furnished
+ * "as is", without any support, and with no warranty, express or implied, as to its usefulness for
+ * any purpose.
+ *
+ * File:      BMP085.h
+ * Purpose:   Split phase driver of the BMP085/BMP180 pressure sensor. Every conversion is started by
+ *            one call and read by another call after the conversion time, the caller waits in
+ *            between (for example with TASK_WAIT_MS). The raw values are compensated with the
+ *            integer algorithm of the datasheet.
+ *            Sequence: startTemperature, wait TEMPERATURE_WAIT_IN_MILLISECONDS, readTemperature,
+ *            startPressure, wait getPressureWaitInMilliseconds, readPressure
+ *
+ * Author:    Volker Böhm
+ * Copyright: Volker Böhm
+ * Version:   1.0
+ * ---------------------------------------------------------------------------------------------------
+ */
+
+#ifndef __BMP085_H
+#define __BMP085_H
+
+#include "StdInclude.h"
+
+class BMP085 {
+public:
+
+    static const uint8_t TEMPERATURE_WAIT_IN_MILLISECONDS = 5;
+
+    /**
+     * Oversampling modes: ultra low power (1 sample) .. ultra high resolution (8 samples)
+     */
+    static const uint8_t ULTRA_LOW_POWER = 0;
+    static const uint8_t ULTRA_HIGH_RESOLUTION = 3;
+
+    BMP085() : mOversampling(ULTRA_HIGH_RESOLUTION), mB5(0) {}
+
+    /**
+     * Checks the chip id and reads the calibration data
+     * @return true, if a sensor is found
+     */
+    bool begin();
+
+    /**
+     * Sets the oversampling mode of the next pressure conversions
+     * @param oversampling ULTRA_LOW_POWER (0) .. ULTRA_HIGH_RESOLUTION (3)
+     */
+    void setOversampling(uint8_t oversampling)
+    {
+        mOversampling = oversampling > ULTRA_HIGH_RESOLUTION ? ULTRA_HIGH_RESOLUTION : oversampling;
+    }
+
+    /**
+     * Gets the conversion time of a pressure conversion
+     * @return time in milliseconds: 5, 8, 14 or 26
+     */
+    uint8_t getPressureWaitInMilliseconds() const { return 2 + (3 << mOversampling); }
+
+    /**
+     * Starts a temperature conversion
+     */
+    void startTemperature();
+
+    /**
+     * Reads and compensates the temperature, the conversion must be finished
+     * @return temperature in 0.1 degree celsius
+     */
+    int16_t readTemperature();
+
+    /**
+     * Starts a pressure conversion with the oversampling mode set
+     */
+    void startPressure();
+
+    /**
+     * Reads and compensates the pressure, the conversion must be finished. Uses the last temperature read.
+     * @return pressure in Pa
+     */
+    int32_t readPressure();
+
+private:
+
+    static const uint8_t ADDRESS = 0x77;
+    static const uint8_t CHIP_ID = 0x55;
+
+    static const uint8_t REGISTER_CALIBRATION = 0xAA;
+    static const uint8_t REGISTER_CHIP_ID = 0xD0;
+    static const uint8_t REGISTER_CONTROL = 0xF4;
+    static const uint8_t REGISTER_DATA = 0xF6;
+
+    static const uint8_t COMMAND_TEMPERATURE = 0x2E;
+    static const uint8_t COMMAND_PRESSURE = 0x34;
+
+    /**
+     * Writes a register
+     * @param reg register address
+     * @param value value to write
+     */
+    void write(uint8_t reg, uint8_t value);
+
+    /**
+     * Reads consecutive registers, the first register to the most significant byte
+     * @param reg address of the first register
+     * @param amount amount of registers (1 .. 3)
+     * @return registers read
+     */
+    uint32_t read(uint8_t reg, uint8_t amount);
+
+    int16_t  mAC1, mAC2, mAC3;
+    uint16_t mAC4, mAC5, mAC6;
+    int16_t  mB1, mB2, mMB, mMC, mMD;
+    uint8_t  mOversampling;
+    int32_t  mB5;
+};
+
+#endif // __BMP085_H
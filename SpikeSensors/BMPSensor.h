@@ -6,16 +6,18 @@
  *
  * File:    BMPSensor.h
  * Purpose: Regularily check the state of a pressure sensor sensor and notify its change
+ *          The sensor is read every SAMPLE_INTERVAL_KEY seconds by a task, the conversions run
+ *          while the task waits (see BMP085), checkState never blocks.
  * Author:    Volker Böhm
  * Copyright: Volker Böhm
  * Version: 1.0
  * ---------------------------------------------------------------------------------------------------
  */
 
-#include <Wire.h>
-#include <Adafruit_BMP085.h>
 #include "Config.h"
 #include "State.h"
+#include "Task.h"
+#include "BMP085.h"
 
 class BMPSensor : public State {
     public:
@@ -25,41 +27,89 @@ class BMPSensor : public State {
          * @param deviceNo number of the device the sensor belongs to
          */
         BMPSensor(device_t deviceNo)
-            :State(deviceNo, AIR_PRESSURE_NOTIFICATION)
+            :State(deviceNo, AIR_PRESSURE_NOTIFICATION), mPressure(0)
         {
+            NotifyTarget::setPriority(NotifyTarget::PRIORITY_BACKGROUND);
+            NotifyTarget::subscribe(SAMPLE_INTERVAL_KEY);
+            NotifyTarget::subscribe(BMP_OVERSAMPLING_KEY);
+            mSampleIntervalInSeconds = addConfigValue(SAMPLE_INTERVAL_KEY, DEFAULT_SAMPLE_INTERVAL_IN_SECONDS);
+            mBmp.setOversampling(addConfigValue(BMP_OVERSAMPLING_KEY, BMP085::ULTRA_HIGH_RESOLUTION));
+            setReportPolicy(10, 0, 5, 0);
             mSensorAvailable = mBmp.begin();
             if (!mSensorAvailable) {
                 printlnIfDebug(F("Could not find a valid BMP085 sensor, check wiring!"));
             }
         }
 
+        /**
+         * Runs the measurement task and checks the last pressure read
+         * @param scheduleLoops number of checkState loops since reboot
+         */
+        virtual void checkState(time_t scheduleLoops)
+        {
+            if (mSensorAvailable) {
+                runMeasurement();
+            }
+            State::checkState(scheduleLoops);
+        }
+
+        /**
+         * Handles changes of the sample interval and the oversampling mode
+         * @param key key/identifier of the change
+         * @param data new value
+         */
+        virtual void handleChange(address_t senderAddress, key_t key, StateValue data)
+        {
+            value_t value = data.toInt();
+            if (key == SAMPLE_INTERVAL_KEY && value >= MIN_SAMPLE_INTERVAL_IN_SECONDS) {
+                setConfigValue(key, value);
+                mSampleIntervalInSeconds = value;
+            }
+            if (key == BMP_OVERSAMPLING_KEY && value <= BMP085::ULTRA_HIGH_RESOLUTION) {
+                setConfigValue(key, value);
+                mBmp.setOversampling(value);
+            }
+            State::handleChange(senderAddress, key, data);
+        }
+
     private:
 
+        static const value_t DEFAULT_SAMPLE_INTERVAL_IN_SECONDS = 10;
+        static const value_t MIN_SAMPLE_INTERVAL_IN_SECONDS = 2;
+
         /**
-         * Checks if the state has changed.
-         * @param curValue current state value
-         * @param lastValue last state value
-         * @return true, if state has changed
+         * Measures temperature and pressure every sample interval. Every conversion is started and
+         * read in different calls, the task waits for the conversion time in between.
+         * @return true, while running (always)
          */
-        virtual bool hasChanged(StateValue curValue, StateValue lastValue)
+        bool runMeasurement()
         {
-            return curValue.toFloat() - lastValue.toFloat() > 10;
-        };
+            TASK_BEGIN(mTask);
+            while (true) {
+                // The pressure compensation needs a current temperature
+                mBmp.startTemperature();
+                TASK_WAIT_MS(mTask, BMP085::TEMPERATURE_WAIT_IN_MILLISECONDS);
+                mBmp.readTemperature();
+                mBmp.startPressure();
+                TASK_WAIT_MS(mTask, mBmp.getPressureWaitInMilliseconds());
+                mPressure = mBmp.readPressure();
+                TASK_WAIT_MS(mTask, time_t(mSampleIntervalInSeconds) * 1000);
+            }
+            TASK_END(mTask);
+        }
 
         /**
-         * Reads the sensor information and notifys his changes
+         * Gets the last pressure read
          */
         StateValue getValue() {
             // Barometric sensor information
-            StateValue result = 0;
-            if (mSensorAvailable) {
-                result = uint16_t(mBmp.readPressure() / 2);
-                //mTemperature = mBmp.readTemperature();
-            }
-            return result;
+            return uint16_t(mPressure / 2);
         }
 
         bool      mSensorAvailable;
-        Adafruit_BMP085 mBmp;
+        int32_t   mPressure;
+        value_t   mSampleIntervalInSeconds;
+        BMP085    mBmp;
+        Task      mTask;
 
 };
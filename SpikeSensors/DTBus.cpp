@@ -0,0 +1,98 @@
+/**
+ * ---------------------------------------------------------------------------------------------------
+ * This software is licensed under the GNU LESSER GENERAL PUBLIC LICENSE Version 3. It is furnished
+ * "as is", without any support, and with no warranty, express or implied, as to its usefulness for
+ * any purpose.
+ *
+ * File:      DTBus.cpp
+ * Author:    Volker Böhm
+ * Copyright: Volker Böhm
+ * ---------------------------------------------------------------------------------------------------
+ */
+
+#include "DTBus.h"
+
+DTBus::DTBus(device_t deviceNo, pin_t pin)
+    : NotifyTarget(deviceNo), mOneWire(pin), mDT(&mOneWire), mValid(0), mSensors(0), mReadIndex(0), mResolutionChanged(true)
+{
+    mResolution = addConfigValue(DT_RESOLUTION_KEY, DEFAULT_RESOLUTION);
+    mPeriodInSeconds = addConfigValue(DT_PERIOD_KEY, DEFAULT_PERIOD_IN_SECONDS);
+    NotifyTarget::setCheckMask(NotifyTarget::CHECKSTATE_SELDOM);
+    NotifyTarget::setPriority(NotifyTarget::PRIORITY_BACKGROUND);
+    NotifyTarget::unsubscribeAll();
+    NotifyTarget::subscribe(DT_RESOLUTION_KEY);
+    NotifyTarget::subscribe(DT_PERIOD_KEY);
+
+    mDT.begin();
+    mDT.setWaitForConversion(false);
+    uint8_t deviceCount = min(mDT.getDeviceCount(), MAX_SENSORS);
+    for (uint8_t index = 0; index < deviceCount; index++) {
+        if (mDT.getAddress(mAddress[index], index)) {
+            mSensors = index + 1;
+        }
+    }
+    if (mSensors == 0) {
+        printIfDebug(F("Could not find a Dallas Temperature sensor on pin "));
+        printlnIfDebug(pin);
+    } else {
+        printIfDebug(F("Dallas Temperature found: "));
+        printlnIfDebug(mSensors);
+    }
+}
+
+bool DTBus::getTemperature(uint8_t index, int16_t& temperature)
+{
+    bool result = index < mSensors && (mValid & (1 << index)) != 0;
+    if (result) {
+        temperature = mTemperature[index];
+    }
+    return result;
+}
+
+void DTBus::checkState(time_t scheduleLoops)
+{
+    runConversion();
+}
+
+void DTBus::handleChange(address_t senderAddress, key_t key, StateValue data)
+{
+    value_t value = data.toInt();
+    if (key == DT_RESOLUTION_KEY && value >= MIN_RESOLUTION && value <= MAX_RESOLUTION) {
+        setConfigValue(DT_RESOLUTION_KEY, value);
+        mResolution = value;
+        mResolutionChanged = true;
+    }
+    if (key == DT_PERIOD_KEY && value >= 1) {
+        setConfigValue(DT_PERIOD_KEY, value);
+        mPeriodInSeconds = value;
+    }
+}
+
+bool DTBus::runConversion()
+{
+    TASK_BEGIN(mTask);
+    while (mSensors > 0) {
+        if (mResolutionChanged) {
+            mResolutionChanged = false;
+            mDT.setResolution(mResolution);
+        }
+        // Convert all: every sensor on the bus starts its conversion, the call does not wait
+        mDT.requestTemperatures();
+        TASK_WAIT_MS(mTask, mDT.millisToWaitForConversion(mResolution));
+
+        for (mReadIndex = 0; mReadIndex < mSensors; mReadIndex++) {
+            {
+                // Raw value in 1/128 degree celsius
+                int32_t temperature = mDT.getTemp(mAddress[mReadIndex]);
+                if (temperature > DEVICE_DISCONNECTED_RAW) {
+                    mTemperature[mReadIndex] = temperature * StateValue::HUNDREDTHS / 128;
+                    mValid |= 1 << mReadIndex;
+                }
+            }
+            // One scratchpad per tick
+            TASK_WAIT_MS(mTask, NotifyTarget::MILLISECONDS_PER_LOOP);
+        }
+        TASK_WAIT_MS(mTask, time_t(mPeriodInSeconds) * 1000 - mDT.millisToWaitForConversion(mResolution));
+    }
+    TASK_END(mTask);
+}
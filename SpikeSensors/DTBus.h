@@ -0,0 +1,91 @@
+/**
+ * ---------------------------------------------------------------------------------------------------
+ * This software is licensed under the GNU LESSER GENERAL PUBLIC LICENSE Version 3. It is furnished
+ * "as is", without any support, and with no warranty, express or implied, as to its usefulness for
+ * any purpose.
+ *
+ * File:      DTBus.h
+ * Purpose:   Shared one-wire bus of the DS18B20 temperature sensors. One "convert all" command starts
+ *            the conversion of all sensors without waiting for it. After the conversion time the
+ *            scratchpads are read, one sensor per tick. The DTSensor objects get the latest temperature
+ *            of their index. No call blocks for the conversion time (750 ms with 12 bits).
+ *            The resolution (DT_RESOLUTION_KEY) and the period (DT_PERIOD_KEY) are configured in the
+ *            device of the first DTSensor.
+ *
+ * Author:    Volker Böhm
+ * Copyright: Volker Böhm
+ * Version:   1.0
+ * ---------------------------------------------------------------------------------------------------
+ */
+
+#ifndef __DTBUS_H
+#define __DTBUS_H
+
+#include <OneWire.h>
+#include <DallasTemperature.h>
+#include "StdInclude.h"
+#include "Task.h"
+
+class DTBus : public NotifyTarget {
+public:
+
+    /**
+     * Maximal amount of sensors on the bus
+     */
+    static const uint8_t MAX_SENSORS = 4;
+
+    /**
+     * Constructs the bus and searches the sensors
+     * @param deviceNo number of the device holding the configuration
+     * @param pin pin of the one-wire bus
+     */
+    DTBus(device_t deviceNo, pin_t pin);
+
+    /**
+     * Gets the latest temperature of a sensor
+     * @param index index of the sensor on the bus
+     * @param temperature output: temperature in 1/100 degree celsius
+     * @return true, if a temperature has been read
+     */
+    bool getTemperature(uint8_t index, int16_t& temperature);
+
+    /**
+     * Runs the conversion task
+     * @param scheduleLoops number of checkState loops since reboot
+     */
+    virtual void checkState(time_t scheduleLoops);
+
+    /**
+     * Handles changes of the resolution and the period
+     * @param key key/identifier of the change
+     * @param data new value
+     */
+    virtual void handleChange(address_t senderAddress, key_t key, StateValue data);
+
+private:
+
+    static const value_t DEFAULT_RESOLUTION = 12;
+    static const value_t MIN_RESOLUTION = 9;
+    static const value_t MAX_RESOLUTION = 12;
+    static const value_t DEFAULT_PERIOD_IN_SECONDS = 60;
+
+    /**
+     * Starts a conversion every period and reads the results
+     * @return true, while running (always)
+     */
+    bool runConversion();
+
+    OneWire             mOneWire;
+    DallasTemperature   mDT;
+    uint8_t             mAddress[MAX_SENSORS][8];
+    int16_t             mTemperature[MAX_SENSORS];
+    uint8_t             mValid;
+    uint8_t             mSensors;
+    uint8_t             mReadIndex;
+    value_t             mResolution;
+    value_t             mPeriodInSeconds;
+    bool                mResolutionChanged;
+    Task                mTask;
+};
+
+#endif // __DTBUS_H
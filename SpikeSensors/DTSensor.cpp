@@ -10,49 +10,38 @@
  * ---------------------------------------------------------------------------------------------------
  */
 
-#include <OneWire.h>
-#include <DallasTemperature.h>
 #include "Config.h"
+#include "SpikeHome.h"
+#include "StaticTopology.h"
+#include "DTBus.h"
 #include "DTSensor.h"
 
-bool DTSensor::mSensorAvailable;
-DallasTemperature* DTSensor::mpDT = 0;
+DTBus* DTSensor::mpBus = 0;
+
+/**
+ * Static memory of the bus shared by all sensors, the bus is constructed with the first sensor
+ */
+static uint8_t busStorage[sizeof(DTBus)];
 
 DTSensor::DTSensor(device_t deviceNo, pin_t pin, uint8_t index)
-    :State(deviceNo, SYS_TEMPERATURE_NOTIFICATION), mNextRead(0)
+    :State(deviceNo, SYS_TEMPERATURE_NOTIFICATION)
 {
     mIndex = index;
-    if (mpDT == 0) {
-        mpDT = new DallasTemperature(new OneWire(pin));
-        mpDT->begin();
-        mSensorAvailable = mpDT->getDeviceCount() > 0;
-
-        if (!mSensorAvailable) {
-            printIfDebug(F("Could not find a Dallas Temperature sensor on pin "));
-            printlnIfDebug(pin);
-        } else {
-            printIfDebug(F("Dallas Temperature found: "));
-            printlnIfDebug(mpDT->getDeviceCount());
-        }
+    NotifyTarget::setPriority(NotifyTarget::PRIORITY_BACKGROUND);
+    if (mpBus == 0) {
+        mpBus = new (StaticPlace(busStorage)) DTBus(deviceNo, pin);
+        SpikeHome::addToSchedule(mpBus);
     }
+    setReportPolicy(50, 0, 5, 0);
 }
 
 
-bool DTSensor::hasChanged(StateValue curValue, StateValue lastValue)
-{
-    return abs(curValue.toFloat() - lastValue.toFloat()) > DTSENSOR_TEMP_DIFFERENCE_TO_REPORT;
-};
-
-/**
- * Reads the sensor information and notifys his changes
- */
 StateValue DTSensor::getValue()
 {
     StateValue result = mLastValue;
-    time_t curTime    = millis();
-    if (mSensorAvailable && mNextRead < curTime && mpDT->requestTemperaturesByIndex(mIndex)) {
-        result = mpDT->getTempCByIndex(mIndex);
-        mNextRead = curTime + MILLISECONDS_IN_A_SECOND * 60;
+    int16_t temperature;
+    if (mpBus->getTemperature(mIndex, temperature)) {
+        result = temperature;
     }
     return result;
 }
@@ -5,7 +5,8 @@
  * any purpose.
  *
  * File:    DTSensor.h
- * Purpose: Controls a DS18B20 Temperature Sensor connected by onewire
+ * Purpose: Controls a DS18B20 Temperature Sensor connected by onewire. The sensors share one bus
+ *          (see DTBus), the sensor gets the latest temperature of its index from the bus.
  *
  * Author:    Volker Böhm
  * Copyright: Volker Böhm
@@ -19,9 +20,7 @@
 
 #include "State.h"
 
-#define DTSENSOR_TEMP_DIFFERENCE_TO_REPORT 0.5
-
-class DallasTemperature;
+class DTBus;
 
 class DTSensor : public State {
 public:
@@ -37,24 +36,14 @@ public:
 private:
 
     /**
-     * Checks if the state has changed.
-     * @param curValue current state value
-     * @param lastValue last state value
-     * @return true, if state has changed
-     */
-    virtual bool hasChanged(StateValue curValue, StateValue lastValue);
-
-    /**
-     * Reads the sensor information returns the value
+     * Gets the latest temperature of the sensor from the bus
      * @return current temperature
      */
     virtual StateValue getValue();
 
 
     uint8_t mIndex;
-    time_t mNextRead;
-    static bool mSensorAvailable;
-    static DallasTemperature* mpDT;
+    static DTBus* mpBus;
 };
 
 #endif // __DTSENSOR_H
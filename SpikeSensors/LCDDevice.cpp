@@ -19,6 +19,7 @@
 
 LCDDevice::LCDDevice(device_t deviceNo) : NotifyTarget(deviceNo), lcd(0x27, 20, 4)
 {
+    NotifyTarget::setPriority(NotifyTarget::PRIORITY_BACKGROUND);
     init();
 }
 
@@ -35,17 +36,17 @@ void LCDDevice::handleChange(address_t senderAddress, key_t key, StateValue valu
         case TEMPERATURE_NOTIFICATION:
             lcd.setCursor(0, 0);
             lcd.print(F("Temp.    : "));
-            lcd.print(value.toFloat());
+            value.print(lcd, key);
             break;
         case HUMIDITY_NOTIFICATION:
             lcd.setCursor(0, 1);
             lcd.print(F("Humidity : "));
-            lcd.print(value.toFloat());
+            value.print(lcd, key);
             break;
         case SYS_TEMPERATURE_NOTIFICATION:
             lcd.setCursor(0, 2);
             lcd.print(F("SysTemp  : "));
-            lcd.print(value.toFloat());
+            value.print(lcd, key);
             break;
         case TIMER_NOTIFICATION:
             lcd.print(value.toInt());
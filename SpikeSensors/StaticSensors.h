@@ -0,0 +1,47 @@
+/**
+ * ---------------------------------------------------------------------------------------------------
+ * This software is licensed under the GNU LESSER GENERAL PUBLIC LICENSE Version 3. It is furnished
+ * "as is", without any support, and with no warranty, express or implied, as to its usefulness for
+ * any purpose.
+ *
+ * File:      StaticSensors.h
+ * Purpose:   Nodes for the static topology (see SpikeHome/StaticTopology.h) of the sensors needing
+ *            additional libraries. Counterpart of the SpikeSensors::add... functions.
+ *            The DS18B20 bus shared by the DTSensor nodes (DTBus with its OneWire and DallasTemperature
+ *            objects) has its own static memory in DTSensor.cpp.
+ *
+ * Author:    Volker Böhm
+ * Copyright: Volker Böhm
+ * Version:   1.0
+ * ---------------------------------------------------------------------------------------------------
+ */
+
+#ifndef __STATICSENSORS_H
+#define __STATICSENSORS_H
+
+#include "StaticTopology.h"
+#include "DTSensor.h"
+#include "LCDDevice.h"
+
+template <pin_t PIN, uint8_t INDEX>
+class DTSensorNode {
+public:
+    typedef DTSensor Target;
+    static const uint8_t LISTENERS = 0;
+    static void setup(device_t deviceNo, const StaticPlace& place)
+    {
+        SpikeHome::addToSchedule(new (place) DTSensor(deviceNo, PIN, INDEX));
+    }
+};
+
+class LCDDeviceNode {
+public:
+    typedef LCDDevice Target;
+    static const uint8_t LISTENERS = 1;
+    static void setup(device_t deviceNo, const StaticPlace& place)
+    {
+        SpikeHome::onChange(new (place) LCDDevice(deviceNo));
+    }
+};
+
+#endif // __STATICSENSORS_H
@@ -0,0 +1,161 @@
+/**
+ * ---------------------------------------------------------------------------------------------------
+ * This software is licensed under the GNU LESSER GENERAL PUBLIC LICENSE Version 3. It is furnished
+ * "as is", without any support, and with no warranty, express or implied, as to its usefulness for
+ * any purpose.
+ *
+ * File:      LightControlSim.cpp
+ * Purpose:   Host simulation of the PI brightness controller (BrightnessControl.h) against a room light
+ *            model. Prints settle time and overshoot of some scenarios to choose the gains.
+ *            Build and run on the host:
+ *
+ *            g++ -O2 -o LightControlSim LightControlSim.cpp && ./LightControlSim [proportional integral]
+ *
+ *            Model, time step 1 ms:
+ *            - Light: the level is faded linearly to the controller output within one control period
+ *              (see Fade), PWM duty cycle = (level / 255) ^ 2.2. The lamp starts to shine at the start
+ *              voltage and reaches its full on brightness (100%) at the full on voltage.
+ *            - Room: brightness = ambient light + lamp light.
+ *            - Sensor: light dependent resistor with a first order lag, read by the 10 bit ADC with the
+ *              divider of BrightnessSensor, +-1 LSB noise, converted back to percent like
+ *              BrightnessSensor::getValue.
+ *            Settled means the real brightness stays within SETTLE_BAND_IN_PERCENT of the target.
+ *
+ * Author:    Volker Böhm
+ * Copyright: Volker Böhm
+ * Version:   1.0
+ * ---------------------------------------------------------------------------------------------------
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "../../SpikeHome/BrightnessControl.h"
+
+static const int    MAX_ANALOG_READ_VALUE = 1023;
+static const int    FULL_ON_BRIGHTNESS = 512;
+static const int    START_VOLTAGE = 60;
+static const int    FULL_ON_VOLTAGE = 230;
+static const int    CONTROL_PERIOD_IN_MILLISECONDS = 20;
+static const double SENSOR_TIME_CONSTANT_IN_MILLISECONDS = 40.0;
+static const double GAMMA = 2.2;
+static const double SETTLE_BAND_IN_PERCENT = 2.0;
+static const int    SIMULATION_TIME_IN_MILLISECONDS = 5000;
+
+struct Scenario {
+    const char* name;
+    int    startTargetInPercent;
+    int    targetInPercent;
+    double startAmbientInPercent;
+    double ambientInPercent;
+};
+
+static const Scenario SCENARIOS[] = {
+    { "switch on, target 60%",      0, 60,  5.0,  5.0 },
+    { "switch on, target 15%",      0, 15,  2.0,  2.0 },
+    { "target 60% -> 30%",         60, 30,  5.0,  5.0 },
+    { "target 30% -> 90%",         30, 90,  5.0,  5.0 },
+    { "daylight +25% at 60%",      60, 60,  5.0, 30.0 },
+    { "daylight -25% at 60%",      60, 60, 30.0,  5.0 }
+};
+
+static double duty(double level)
+{
+    return pow(level / 255.0, GAMMA);
+}
+
+/**
+ * Brightness of the lamp in percent of its full on brightness
+ */
+static double lampBrightness(double level)
+{
+    double relative = (duty(level) - duty(START_VOLTAGE)) / (duty(FULL_ON_VOLTAGE) - duty(START_VOLTAGE));
+    return 100.0 * (relative < 0.0 ? 0.0 : (relative > 1.0 ? 1.0 : relative));
+}
+
+/**
+ * Reads the sensor like BrightnessSensor::getValue
+ */
+static int readPercent(double brightnessInPercent)
+{
+    double linear = brightnessInPercent * FULL_ON_BRIGHTNESS / 100.0;
+    int adc = int(MAX_ANALOG_READ_VALUE * linear / (MAX_ANALOG_READ_VALUE - FULL_ON_BRIGHTNESS + linear) + 0.5);
+    adc += rand() % 3 - 1;
+    adc = adc < 0 ? 0 : (adc > MAX_ANALOG_READ_VALUE - 1 ? MAX_ANALOG_READ_VALUE - 1 : adc);
+    long dividend = long(adc) * (MAX_ANALOG_READ_VALUE - FULL_ON_BRIGHTNESS);
+    long divisor = long(MAX_ANALOG_READ_VALUE - adc) * FULL_ON_BRIGHTNESS;
+    return int(100L * dividend / divisor);
+}
+
+/**
+ * Finds the level keeping a brightness in steady state
+ */
+static int findLevel(double lampInPercent)
+{
+    int level = START_VOLTAGE;
+    while (level < FULL_ON_VOLTAGE && lampBrightness(level) < lampInPercent) {
+        level++;
+    }
+    return level;
+}
+
+static void simulate(const Scenario& scenario, uint16_t proportionalGain, uint16_t integralGain)
+{
+    BrightnessControl control;
+    control.setGains(proportionalGain, integralGain);
+
+    int offset = 0;
+    if (scenario.startTargetInPercent > 0) {
+        offset = findLevel(scenario.startTargetInPercent - scenario.startAmbientInPercent) - START_VOLTAGE;
+    }
+    control.reset(offset);
+    double level = offset == 0 ? 0 : START_VOLTAGE + offset;
+    double fadeFrom = level;
+    double fadeTo = level;
+    double sensed = scenario.startAmbientInPercent + lampBrightness(level);
+
+    int target = scenario.targetInPercent;
+    int settledAt = 0;
+    double overshoot = 0.0;
+    bool rising = target + scenario.startAmbientInPercent >= scenario.startTargetInPercent + scenario.ambientInPercent;
+
+    for (int time = 0; time < SIMULATION_TIME_IN_MILLISECONDS; time++) {
+        if (time % CONTROL_PERIOD_IN_MILLISECONDS == 0) {
+            offset = control.step(target, readPercent(sensed), 1, FULL_ON_VOLTAGE - START_VOLTAGE);
+            fadeFrom = level;
+            fadeTo = START_VOLTAGE + offset;
+        }
+        level = fadeFrom + (fadeTo - fadeFrom) * (time % CONTROL_PERIOD_IN_MILLISECONDS + 1) / CONTROL_PERIOD_IN_MILLISECONDS;
+        double brightness = scenario.ambientInPercent + lampBrightness(level);
+        sensed += (brightness - sensed) / SENSOR_TIME_CONSTANT_IN_MILLISECONDS;
+
+        double deviation = brightness - target;
+        overshoot = rising ? fmax(overshoot, deviation) : fmax(overshoot, -deviation);
+        if (fabs(deviation) > SETTLE_BAND_IN_PERCENT) {
+            settledAt = time + 1;
+        }
+    }
+
+    if (settledAt >= SIMULATION_TIME_IN_MILLISECONDS) {
+        printf("%-28s  not settled  overshoot %5.1f%%\n", scenario.name, overshoot);
+    } else {
+        printf("%-28s  %5d ms     overshoot %5.1f%%\n", scenario.name, settledAt, overshoot);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    uint16_t proportionalGain = BrightnessControl::DEFAULT_PROPORTIONAL_GAIN;
+    uint16_t integralGain = BrightnessControl::DEFAULT_INTEGRAL_GAIN;
+    if (argc == 3) {
+        proportionalGain = uint16_t(atoi(argv[1]));
+        integralGain = uint16_t(atoi(argv[2]));
+    }
+    printf("proportional gain %u/256, integral gain %u/256, control period %d ms\n",
+        proportionalGain, integralGain, CONTROL_PERIOD_IN_MILLISECONDS);
+    srand(1);
+    for (unsigned index = 0; index < sizeof(SCENARIOS) / sizeof(SCENARIOS[0]); index++) {
+        simulate(SCENARIOS[index], proportionalGain, integralGain);
+    }
+    return 0;
+}
@@ -29,76 +29,23 @@
 
 
 
+#include "StaticSensors.h"
+
 class YahaMaster {
 
 public:
 
-    /**
-     * Initializes the elements of the first device
-     */
-    static void setupDevice1()
-    {
-        const int16_t DEVICE_INDEX = 0;
-        SpikeHome::addActivity(DEVICE_INDEX);
-        SpikeHome::addLight(DEVICE_INDEX, BRIGHTNES_DEVICE1, LIGHTPWM_DEVICE1);
-
-        SpikeHome::addMovementSensor(DEVICE_INDEX, MOVEMENT_DEVICE1_1, 1);
-        SpikeHome::addMovementSensor(DEVICE_INDEX, MOVEMENT_DEVICE1_2, 3);
-        SpikeHome::addDHTSensor(DEVICE_INDEX, DHT_DEVICE1);
-        SpikeHome::addWaterSensor(DEVICE_INDEX, ANALOG_DEVICE1);
-        SpikeHome::addWindowSensor(DEVICE_INDEX, WINDOW_DEVICE1);
-
-        SpikeSensors::addDTSensor(DEVICE_INDEX, DALLAS_TEMPERATURE_PIN, DT_DEVICE1_INDEX);
-      
-    }
-
-    /**
-     * Initializes the elements of the second device
-     */
-    static void setupDevice2()
-    {
-        const int16_t DEVICE_INDEX = 1;
-        SpikeHome::addActivity(DEVICE_INDEX);
-        SpikeHome::addLight(DEVICE_INDEX, BRIGHTNES_DEVICE2, LIGHTPWM_DEVICE2);
-        
-        SpikeHome::addMovementSensor(DEVICE_INDEX, MOVEMENT_DEVICE2_1, 1);
-        SpikeHome::addMovementSensor(DEVICE_INDEX, MOVEMENT_DEVICE2_2, 1);
-        SpikeHome::addDHTSensor(DEVICE_INDEX, DHT_DEVICE2);
-        SpikeHome::addWaterSensor(DEVICE_INDEX, ANALOG_DEVICE2);
-        SpikeHome::addWindowSensor(DEVICE_INDEX, WINDOW_DEVICE1);
-        
-        SpikeSensors::addDTSensor(DEVICE_INDEX, DALLAS_TEMPERATURE_PIN, DT_DEVICE2_INDEX);
-    }
-
-    /**
-     * Initializes the elements of the third device
-     */
-    static void setupDevice3()
-    {
-        const int16_t DEVICE_INDEX = 2;
-
-        SpikeHome::addLight(DEVICE_INDEX, BRIGHTNES_DEVICE2, LIGHTPWM_DEVICE2);
-        SpikeHome::addMovementSensor(DEVICE_INDEX, MOVEMENT_DEVICE3_1, 1);
-        SpikeSensors::addDTSensor(DEVICE_INDEX, DALLAS_TEMPERATURE_PIN, DT_DEVICE3_INDEX);
-      
-    }
-
-
     /**
      * Initializes all sensors including the serial connection over RS485_HARDWARE_SERIAL
      */
     static void setupSensors(value_t softwareVersion)
     {
-        //SpikeHome::initTextIO(softwareVersion, DEVICE_AMOUNT, SERIAL_SPEED);
-        SpikeHome::initRS485(softwareVersion, DEVICE_AMOUNT, SERIAL_SPEED, SERIAL_TX_CONTROL_PIN, &Serial);
-
-        YahaMaster::setupDevice1();
-        YahaMaster::setupDevice2();
-        YahaMaster::setupDevice3();
+        //SpikeHome::initTextIO(softwareVersion, Topology::DEVICE_AMOUNT, SERIAL_SPEED);
+        SpikeHome::initRS485(softwareVersion, Topology::DEVICE_AMOUNT, SERIAL_SPEED, SERIAL_TX_CONTROL_PIN, &Serial);
+        Topology::setup();
     }
 
 private:
-    static const device_t   DEVICE_AMOUNT           = 3;
     static const time_t     SERIAL_SPEED            = 57600;
 
     static const pin_t      LIGHTPWM_DEVICE1        = 3;
@@ -129,6 +76,45 @@ private:
     static const pin_t      DT_DEVICE2_INDEX        = 1;
     static const pin_t      DT_DEVICE3_INDEX        = 2;
 
+    /**
+     * Elements of the first device
+     */
+    typedef StaticDevice<0,
+        ActivityNode,
+        LightNode<BRIGHTNES_DEVICE1, LIGHTPWM_DEVICE1>,
+        MovementSensorNode<MOVEMENT_DEVICE1_1, 1>,
+        MovementSensorNode<MOVEMENT_DEVICE1_2, 3>,
+        DHTSensorNode<DHT_DEVICE1>,
+        WaterSensorNode<ANALOG_DEVICE1>,
+        WindowSensorNode<WINDOW_DEVICE1>,
+        DTSensorNode<DALLAS_TEMPERATURE_PIN, DT_DEVICE1_INDEX>
+    > Device1;
+
+    /**
+     * Elements of the second device
+     */
+    typedef StaticDevice<1,
+        ActivityNode,
+        LightNode<BRIGHTNES_DEVICE2, LIGHTPWM_DEVICE2>,
+        MovementSensorNode<MOVEMENT_DEVICE2_1, 1>,
+        MovementSensorNode<MOVEMENT_DEVICE2_2, 1>,
+        DHTSensorNode<DHT_DEVICE2>,
+        WaterSensorNode<ANALOG_DEVICE2>,
+        WindowSensorNode<WINDOW_DEVICE1>,
+        DTSensorNode<DALLAS_TEMPERATURE_PIN, DT_DEVICE2_INDEX>
+    > Device2;
+
+    /**
+     * Elements of the third device
+     */
+    typedef StaticDevice<2,
+        LightNode<BRIGHTNES_DEVICE2, LIGHTPWM_DEVICE2>,
+        MovementSensorNode<MOVEMENT_DEVICE3_1, 1>,
+        DTSensorNode<DALLAS_TEMPERATURE_PIN, DT_DEVICE3_INDEX>
+    > Device3;
+
+    typedef StaticTopology<Device1, Device2, Device3> Topology;
+
 };
 
 